@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+#include <btree_map.hpp>
+#include <rbtree.hpp>
+
+struct Entry;
+
+using EntryTree = RbTree<Entry, std::less<>, false>;
+
+struct Entry : EntryTree::RbNode {
+    std::uint64_t mKey;
+    std::uint64_t mValue;
+
+    friend bool operator<(Entry const &lhs, Entry const &rhs) noexcept {
+        return lhs.mKey < rhs.mKey;
+    }
+
+    friend bool operator<(Entry const &lhs, std::uint64_t rhs) noexcept {
+        return lhs.mKey < rhs;
+    }
+
+    friend bool operator<(std::uint64_t lhs, Entry const &rhs) noexcept {
+        return lhs < rhs.mKey;
+    }
+};
+
+template <class F>
+void bench(char const *name, std::size_t times, F &&func) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t sum = func();
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-24s %12zu ops %10.2f ns/op  (%llu)\n", name, times,
+                ns / times, static_cast<unsigned long long>(sum));
+}
+
+// 随机顺序插入 n 个键后做随机 lower_bound 查找，查找的键一半命中
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t lookups =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+
+    std::mt19937_64 rng(42);
+    std::vector<std::uint64_t> keys(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys[i] = i * 2;
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<std::uint64_t> probes(lookups);
+    for (auto &p: probes) {
+        p = rng() % (n * 2);
+    }
+
+    {
+        BTreeMap<std::uint64_t, std::uint64_t> map;
+        bench("BTreeMap insert", n, [&] {
+            for (auto k: keys) {
+                map.insert(k, k);
+            }
+            return map.size();
+        });
+        bench("BTreeMap lower_bound", lookups, [&] {
+            std::uint64_t sum = 0;
+            for (auto p: probes) {
+                auto it = map.lower_bound(p);
+                sum += it != map.end() ? *it : 0;
+            }
+            return sum;
+        });
+        bench("BTreeMap iterate", n, [&] {
+            std::uint64_t sum = 0;
+            for (auto v: map) {
+                sum += v;
+            }
+            return sum;
+        });
+    }
+
+    {
+        std::vector<Entry> entries(n);
+        EntryTree tree;
+        bench("RbTree insert", n, [&] {
+            for (std::size_t i = 0; i < n; ++i) {
+                entries[i].mKey = keys[i];
+                entries[i].mValue = keys[i];
+                tree.insert(entries[i]);
+            }
+            return std::uint64_t(n);
+        });
+        bench("RbTree lower_bound", lookups, [&] {
+            std::uint64_t sum = 0;
+            for (auto p: probes) {
+                auto it = tree.lower_bound(p);
+                sum += it != tree.end() ? it->mValue : 0;
+            }
+            return sum;
+        });
+        bench("RbTree iterate", n, [&] {
+            std::uint64_t sum = 0;
+            for (Entry &e: tree) {
+                sum += e.mValue;
+            }
+            return sum;
+        });
+        tree.clear();
+    }
+
+    {
+        std::map<std::uint64_t, std::uint64_t> map;
+        bench("std::map insert", n, [&] {
+            for (auto k: keys) {
+                map.emplace(k, k);
+            }
+            return map.size();
+        });
+        bench("std::map lower_bound", lookups, [&] {
+            std::uint64_t sum = 0;
+            for (auto p: probes) {
+                auto it = map.lower_bound(p);
+                sum += it != map.end() ? it->second : 0;
+            }
+            return sum;
+        });
+        bench("std::map iterate", n, [&] {
+            std::uint64_t sum = 0;
+            for (auto &[k, v]: map) {
+                sum += v;
+            }
+            return sum;
+        });
+    }
+
+    return 0;
+}
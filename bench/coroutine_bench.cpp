@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <co_runtime.hpp>
+
+// 统计全局 operator new 的次数，协程帧也从这里分配
+// 替换函数内部用 malloc/free 配对；不内联，免得 GCC 在调用处看到
+// free 作用于 operator new 的返回值而报 -Wmismatched-new-delete
+static std::size_t gAllocations = 0;
+
+[[gnu::noinline]] void *operator new(std::size_t size) {
+    ++gAllocations;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static std::uint64_t cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Sample {
+    double ns;
+    std::uint64_t cycles;
+    std::size_t allocations;
+};
+
+constexpr int kRounds = 5;
+
+template <class F>
+Sample measure(F &&func) {
+    std::size_t a0 = gAllocations;
+    std::uint64_t c0 = cycles();
+    auto t0 = std::chrono::steady_clock::now();
+    func();
+    auto t1 = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::nano>(t1 - t0).count(),
+            cycles() - c0, gAllocations - a0};
+}
+
+// 报告按耗时排序的中位数那一轮
+static void report(char const *name, std::size_t ops,
+                   std::vector<Sample> samples) {
+    std::sort(samples.begin(), samples.end(),
+              [](Sample const &lhs, Sample const &rhs) {
+                  return lhs.ns < rhs.ns;
+              });
+    Sample const &s = samples[samples.size() / 2];
+    std::printf("%-26s %8zu ops %9.2f ns/op %9.1f cycles/op %6.2f allocs/op\n",
+                name, ops, s.ns / ops, double(s.cycles) / ops,
+                double(s.allocations) / ops);
+}
+
+// 预热一轮后重复 kRounds 轮，func 每次执行 ops 个操作
+template <class F>
+void bench(char const *name, std::size_t ops, F &&func) {
+    func();
+    std::vector<Sample> samples;
+    for (int i = 0; i < kRounds; ++i) {
+        samples.push_back(measure(func));
+    }
+    report(name, ops, std::move(samples));
+}
+
+static std::size_t gSink = 0;
+
+Task<int> leaf() {
+    co_return 1;
+}
+
+Task<std::size_t> awaitLeaves(std::size_t n) {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        sum += co_await leaf();
+    }
+    co_return sum;
+}
+
+// 每层 co_await 下一层，返回时逐层对称转移回去
+Task<std::size_t> chain(std::size_t depth) {
+    if (depth == 0) {
+        co_return 0;
+    }
+    co_return co_await chain(depth - 1) + 1;
+}
+
+// when_all / when_any 的子任务须有返回值
+template <std::size_t... Is>
+Task<int> allOf(std::index_sequence<Is...>) {
+    co_await when_all(((void)Is, leaf())...);
+    co_return 0;
+}
+
+// 变参 when_all 的实参个数受模板实例化深度限制，1024 路用 32 x 32 两层展开
+template <std::size_t... Is>
+Task<void> allOf1024(std::index_sequence<Is...>) {
+    co_await when_all(((void)Is, allOf(std::make_index_sequence<32>{}))...);
+}
+
+template <std::size_t N>
+Task<void> repeatAll(std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if constexpr (N == 1024) {
+            co_await allOf1024(std::make_index_sequence<32>{});
+        } else {
+            co_await allOf(std::make_index_sequence<N>{});
+        }
+    }
+}
+
+// when_any 的落败者须挂在定时器上（销毁时会自动摘除），
+// 这里每个子任务都是已经到期的 sleep_until，调度器唤醒最早的一个
+inline std::chrono::system_clock::time_point past() {
+    return std::chrono::system_clock::time_point{} + std::chrono::seconds(1);
+}
+
+Task<int> sleeper(std::chrono::system_clock::time_point expireTime) {
+    co_await sleep_until(expireTime);
+    co_return 0;
+}
+
+template <std::size_t... Is>
+Task<int> anyOf(std::index_sequence<Is...>) {
+    co_await when_any(sleeper(past() + std::chrono::nanoseconds(Is))...);
+    co_return 0;
+}
+
+template <std::size_t... Is>
+Task<void> anyOf1024(std::index_sequence<Is...>) {
+    co_await when_any(((void)Is, anyOf(std::make_index_sequence<32>{}))...);
+}
+
+template <std::size_t N>
+Task<void> repeatAny(std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if constexpr (N == 1024) {
+            co_await anyOf1024(std::make_index_sequence<32>{});
+        } else {
+            co_await anyOf(std::make_index_sequence<N>{});
+        }
+    }
+}
+
+Task<void> yielder(std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        co_await reschedule();
+    }
+}
+
+// 16 个协程同时让出，每轮 runReady 恢复 16 个，时钟读取在一轮内分摊
+Task<int> yieldCount(std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        co_await reschedule();
+    }
+    co_return 0;
+}
+
+template <std::size_t... Is>
+Task<int> yieldAll(std::size_t n, std::index_sequence<Is...>) {
+    co_await when_all(((void)Is, yieldCount(n))...);
+    co_return 0;
+}
+
+Task<void> nothing() {
+    co_return;
+}
+
+template <class T>
+T runTask(Task<T> const &task) {
+    getLoop().run(task);
+    return task.mCoroutine.promise().ReturnResult();
+}
+
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t timers =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+
+    bench("task create/destroy", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            auto t = leaf();
+            gSink += t.mCoroutine.address() != nullptr;
+        }
+    });
+
+    bench("co_await ready child", n, [&] {
+        auto t = awaitLeaves(n);
+        gSink += runTask(t);
+    });
+
+    std::size_t depth = 1000;
+    bench("symmetric-transfer chain", n, [&] {
+        for (std::size_t i = 0; i < n / depth; ++i) {
+            auto t = chain(depth);
+            gSink += runTask(t);
+        }
+    });
+
+    bench("when_all x2", n, [&] {
+        auto t = repeatAll<2>(n);
+        runTask(t);
+    });
+    bench("when_all x16", n / 8, [&] {
+        auto t = repeatAll<16>(n / 8);
+        runTask(t);
+    });
+    bench("when_all x1024 (32x32)", n / 512, [&] {
+        auto t = repeatAll<1024>(n / 512);
+        runTask(t);
+    });
+
+    bench("when_any x2", n / 2, [&] {
+        auto t = repeatAny<2>(n / 2);
+        runTask(t);
+    });
+    bench("when_any x16", n / 16, [&] {
+        auto t = repeatAny<16>(n / 16);
+        runTask(t);
+    });
+    bench("when_any x1024 (32x32)", n / 1024, [&] {
+        auto t = repeatAny<1024>(n / 1024);
+        runTask(t);
+    });
+
+    // 到期时间打乱后插入，再由调度器按时间顺序全部唤醒
+    std::vector<std::chrono::nanoseconds> offsets(timers);
+    for (std::size_t i = 0; i < timers; ++i) {
+        offsets[i] = std::chrono::nanoseconds(i);
+    }
+    std::shuffle(offsets.begin(), offsets.end(), std::mt19937_64(42));
+    using SleepTask = Task<void, SleepUntilPromise>;
+    std::vector<std::unique_ptr<SleepTask>> sleepers(timers);
+    std::vector<Sample> inserts, expires;
+    // 第 0 轮预热；每轮先在计时外创建好协程，分别计时插入与全部唤醒
+    for (int round = 0; round <= kRounds; ++round) {
+        for (std::size_t i = 0; i < timers; ++i) {
+            sleepers[i].reset(new SleepTask(sleep_until(past() + offsets[i])));
+        }
+        Sample insert = measure([&] {
+            for (auto &s: sleepers) {
+                s->mCoroutine.resume();
+            }
+        });
+        auto root = nothing();
+        Sample expire = measure([&] { getLoop().run(root); });
+        if (round != 0) {
+            inserts.push_back(insert);
+            expires.push_back(expire);
+        }
+    }
+    report("timer insert", timers, std::move(inserts));
+    report("timer expire", timers, std::move(expires));
+
+    // 上面的定时器都以纪元附近为到期时间，迟到统计没有意义
+    getLoop().resetLatency();
+    bench("ready queue push/pop", n, [&] {
+        auto t = yielder(n);
+        runTask(t);
+    });
+    bench("ready queue push/pop x16", n / 16 * 16, [&] {
+        auto t = yieldAll(n / 16, std::make_index_sequence<16>{});
+        gSink += runTask(t);
+    });
+
+    // 延迟直方图的单次记录，值跨越多个数量级
+    LatencyHistogram histogram;
+    std::vector<std::uint64_t> latencies(4096);
+    std::mt19937_64 rng(7);
+    for (auto &v: latencies) {
+        v = rng() >> (rng() % 64);
+    }
+    bench("latency histogram record", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            histogram.record(latencies[i % latencies.size()]);
+        }
+    });
+    // CO_LATENCY 时每轮调度一次的读时钟，加上每个协程出队时的换算与记录
+    LatencyClock clock;
+    bench("latency record + clock", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint64_t t0 = LatencyClock::now();
+            histogram.record(clock.nanosBetween(t0, LatencyClock::now()));
+        }
+    });
+    gSink += histogram.count();
+#if CO_LATENCY
+    getLoop().writeLatency(std::cout);
+#endif
+
+    return gSink == 0;
+}
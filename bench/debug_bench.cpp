@@ -0,0 +1,73 @@
+#define DEBUG_ASYNC 1
+// 无论构建类型如何都保留全部级别，测量输出路径
+#define DEBUG_MIN_LEVEL 0
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <debug.hpp>
+
+template <class F>
+void bench(char const *name, std::size_t times, F &&func) {
+    auto t0 = std::chrono::steady_clock::now();
+    func();
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-24s %10zu ops %10.2f ns/op\n", name, times, ns / times);
+}
+
+// 日志写到 stderr，测量时建议重定向：debug_bench 2>/dev/null
+// 同步基线按 debug 原来的方式格式化后直接写 std::cerr
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+    bench("sync ostringstream+cerr", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::ostringstream oss;
+            oss << "debug_bench.cpp:" << __LINE__ << ":\t" << "\"tick\"" << ' '
+                << i << ' ' << 3.25 << '\n';
+            std::cerr << oss.str();
+        }
+    });
+
+    bench("debug() async", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug(), "tick", i, 3.25;
+        }
+    });
+
+    debug_async::flush();
+    std::printf("dropped %zu of %zu records\n", debug_async::dropped(), n);
+
+    // 运行期过滤：debug_trace() 仍会求值参数，DEBUG_LOG 只做一次比较
+    debug_logger::set_level(debug_level::info);
+    bench("debug_trace() filtered", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug_trace(), "tick", std::to_string(i);
+        }
+    });
+
+    bench("DEBUG_LOG(trace) filtered", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            DEBUG_LOG(trace), "tick", std::to_string(i);
+        }
+    });
+    debug_logger::set_level(debug_level::trace);
+
+    // 热点调用点的洪泛：限流与采样在格式化之前丢弃记录
+    bench("rate_limit(100)", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug().rate_limit(100), "tick", i, 3.25;
+        }
+    });
+
+    bench("sample(1000)", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug().sample(1000), "tick", i, 3.25;
+        }
+    });
+    return 0;
+}
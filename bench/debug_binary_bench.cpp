@@ -0,0 +1,32 @@
+#define DEBUG_BINARY 1
+#define DEBUG_MIN_LEVEL 0
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <debug.hpp>
+
+// 与 debug_bench 相同的调用，格式化推迟到后台线程
+// 日志写到 stderr，测量时建议重定向：debug_binary_bench 2>/dev/null
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    // 分批提交，给后台线程留出解码时间，避免测成环满丢弃的开销
+    std::size_t batch = 1000;
+
+    // 只计调用方的时间，每批之后的 flush 在计时之外
+    std::chrono::steady_clock::duration spent{};
+    for (std::size_t i = 0; i < n; i += batch) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (std::size_t j = i; j < i + batch && j < n; ++j) {
+            debug(), "tick", j, 3.25;
+        }
+        spent += std::chrono::steady_clock::now() - t0;
+        debug_async::flush();
+    }
+    double ns = std::chrono::duration<double, std::nano>(spent).count();
+    std::printf("%-24s %10zu ops %10.2f ns/op\n", "debug() binary", n, ns / n);
+
+    debug_async::flush();
+    std::printf("dropped %zu of %zu records\n", debug_async::dropped(), n);
+    return 0;
+}
@@ -0,0 +1,67 @@
+// 保留全部级别，同步输出，测量格式化本身
+#define DEBUG_MIN_LEVEL 0
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <debug.hpp>
+
+// 丢弃写入内容的 streambuf，避免把系统调用算进去
+struct null_buffer : std::streambuf {
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(char const *, std::streamsize n) override {
+        return n;
+    }
+};
+
+template <class F>
+void bench(char const *name, std::size_t times, F &&func) {
+    auto t0 = std::chrono::steady_clock::now();
+    func();
+    auto t1 = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("%-24s %10zu records %12.0f records/s %8.1f ns/record\n", name,
+                times, times / s, s * 1e9 / times);
+}
+
+// 每种记录覆盖一类参数：有符号与无符号整数、浮点、带转义的字符串、
+// C 字符串、字符以及容器
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+
+    null_buffer sink;
+    auto *saved = std::cerr.rdbuf(&sink);
+
+    std::string path = "/var/log/app\tlatest.log";
+    std::vector<int> sizes{1, 22, 333, 4444};
+    bench("integers", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug(), "tick", static_cast<int>(i), i, -42L;
+        }
+    });
+    bench("floats", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug(), 3.25 * i, 0.5f;
+        }
+    });
+    bench("strings", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug(), "open", path, 'x';
+        }
+    });
+    bench("container", n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            debug(), "sizes", sizes;
+        }
+    });
+
+    std::cerr.rdbuf(saved);
+    return 0;
+}
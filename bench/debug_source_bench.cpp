@@ -0,0 +1,39 @@
+// 回显源码行，保留全部级别，同步输出到丢弃内容的 streambuf
+#define DEBUG_SHOW_SOURCE 1
+#define DEBUG_MIN_LEVEL 0
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <debug.hpp>
+
+struct null_buffer : std::streambuf {
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(char const *, std::streamsize n) override {
+        return n;
+    }
+};
+
+// 源文件须在运行目录下可按编译时的路径找到，否则只输出 [?]
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+    null_buffer sink;
+    auto *saved = std::cerr.rdbuf(&sink);
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        debug(), "tick", i;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::cerr.rdbuf(saved);
+
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("%-24s %10zu records %12.0f records/s %8.1f ns/record\n",
+                "debug() with source", n, n / s, s * 1e9 / n);
+    return 0;
+}
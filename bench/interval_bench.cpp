@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <rbtree.hpp>
+
+struct Lease;
+
+struct LeaseEnd {
+    template <class T>
+    std::int64_t operator()(T const &lease) const noexcept {
+        return lease.mEnd;
+    }
+};
+
+// 按起点排序的区间树，结点不保存树指针
+using LeaseTree = RbTree<Lease, std::less<>, false,
+                         RbIntervalAugment<std::int64_t, LeaseEnd>>;
+
+// 租约占用 [mStart, mEnd)
+struct Lease : LeaseTree::RbNode {
+    std::int64_t mStart;
+    std::int64_t mEnd;
+
+    friend bool operator<(Lease const &lhs, Lease const &rhs) noexcept {
+        return lhs.mStart < rhs.mStart;
+    }
+
+    friend bool operator<(Lease const &lhs, std::int64_t rhs) noexcept {
+        return lhs.mStart < rhs;
+    }
+
+    friend bool operator<(std::int64_t lhs, Lease const &rhs) noexcept {
+        return lhs < rhs.mStart;
+    }
+};
+
+template <class F>
+void bench(char const *name, std::size_t times, F &&func) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::size_t hits = func();
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-24s %10zu ops %12.2f ns/op  hits %zu\n", name, times,
+                ns / times, hits);
+}
+
+// n 个长度随机的租约，查询随机窗口内相交的租约，与逐个扫描对照
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t queries =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+    std::int64_t span = static_cast<std::int64_t>(n) * 100;
+
+    std::mt19937_64 rng(42);
+    std::vector<Lease> leases(n);
+    LeaseTree tree;
+    auto arm = [&](Lease &lease) {
+        lease.mStart = static_cast<std::int64_t>(rng() % span);
+        lease.mEnd = lease.mStart + 1 +
+                     static_cast<std::int64_t>(rng() % (rng() % 8 == 0 ? 5000 : 200));
+        tree.insert(lease);
+    };
+    for (auto &lease: leases) {
+        arm(lease);
+    }
+
+    // 续约：删除后以新的区间重新加入，检验旋转与删除时端点最大值的维护
+    for (std::size_t i = 0; i < n; ++i) {
+        Lease &lease = leases[rng() % n];
+        tree.erase(lease);
+        arm(lease);
+    }
+    if (!tree.validate()) {
+        std::printf("FAILED: %s\n", tree.validate().error);
+        return 1;
+    }
+
+    std::vector<std::pair<std::int64_t, std::int64_t>> windows(queries);
+    for (auto &[lo, hi]: windows) {
+        lo = static_cast<std::int64_t>(rng() % span);
+        hi = lo + 1 + static_cast<std::int64_t>(rng() % 1000);
+    }
+
+    std::vector<std::size_t> expected(queries);
+    bench("linear scan", queries, [&] {
+        std::size_t hits = 0;
+        for (std::size_t q = 0; q < queries; ++q) {
+            auto [lo, hi] = windows[q];
+            for (Lease const &lease: leases) {
+                expected[q] += lease.mStart < hi && lease.mEnd > lo;
+            }
+            hits += expected[q];
+        }
+        return hits;
+    });
+
+    std::size_t mismatches = 0;
+    bench("for_each_overlapping", queries, [&] {
+        std::size_t hits = 0;
+        for (std::size_t q = 0; q < queries; ++q) {
+            auto [lo, hi] = windows[q];
+            std::size_t found = 0;
+            tree.for_each_overlapping(lo, hi, [&](Lease &) { ++found; });
+            mismatches += found != expected[q];
+            hits += found;
+        }
+        return hits;
+    });
+
+    tree.clear();
+    if (mismatches != 0) {
+        std::printf("FAILED: %zu queries differ from linear scan\n",
+                    mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <rb_map.hpp>
+
+// n 个键常驻，每轮删除一个随机键再插入一个新键，比较逐元素 malloc 的
+// std::map 与从 SlabPool 分配的 RbMap
+template <class Map, class Emplace>
+void bench(char const *name, std::size_t n, std::size_t rounds,
+           Emplace &&emplace) {
+    std::mt19937_64 rng(42);
+    Map map;
+    for (std::size_t i = 0; i < n; ++i) {
+        emplace(map, rng() % (n * 4), i);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < rounds; ++i) {
+        hits += map.erase(rng() % (n * 4));
+        emplace(map, rng() % (n * 4), i);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-10s %10zu keys %10.2f ns/round  size %zu  hit %zu\n", name,
+                n, ns / rounds, map.size(), hits);
+}
+
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t rounds =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+
+    bench<std::map<std::uint64_t, std::uint64_t>>(
+        "std::map", n, rounds,
+        [](auto &map, std::uint64_t key, std::uint64_t value) {
+            map.try_emplace(key, value);
+        });
+    bench<RbMap<std::uint64_t, std::uint64_t>>(
+        "RbMap", n, rounds,
+        [](auto &map, std::uint64_t key, std::uint64_t value) {
+            map.emplace(key, value);
+        });
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <ranges>
+#include <random>
+#include <vector>
+#include <rbtree.hpp>
+
+struct Timer;
+
+// 与 main.cpp 中的定时器树一致，结点不保存树指针
+using TimerTree = RbTree<Timer, std::less<Timer>, false>;
+
+struct Timer : TimerTree::RbNode {
+    std::int64_t mExpireTime;
+
+    friend bool operator<(Timer const &lhs, Timer const &rhs) noexcept {
+        return lhs.mExpireTime < rhs.mExpireTime;
+    }
+};
+
+static_assert(std::ranges::bidirectional_range<TimerTree>);
+
+// 防止编译器把被测代码优化掉
+template <class T>
+inline void doNotOptimize(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <class F>
+void bench(char const *name, std::size_t times, F &&func) {
+    auto t0 = std::chrono::steady_clock::now();
+    func();
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-24s %12zu ops %10.2f ns/op\n", name, times, ns / times);
+}
+
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t times = 10000000;
+
+    std::printf("sizeof(RbNode) = %zu, with AutoUnlink = %zu\n",
+                sizeof(TimerTree::RbNode), sizeof(RbTree<Timer>::RbNode));
+
+    std::mt19937_64 rng(42);
+    std::vector<Timer> timers(n);
+    TimerTree tree;
+
+    bench("insert", n, [&] {
+        for (auto &t: timers) {
+            t.mExpireTime = static_cast<std::int64_t>(rng() % (n * 16));
+            tree.insert(t);
+        }
+    });
+
+    bench("front", times, [&] {
+        for (std::size_t i = 0; i < times; ++i) {
+            doNotOptimize(tree.front().mExpireTime);
+        }
+    });
+
+    bench("back", times, [&] {
+        for (std::size_t i = 0; i < times; ++i) {
+            doNotOptimize(tree.back().mExpireTime);
+        }
+    });
+
+    bench("iterate", n, [&] {
+        for (Timer &t: tree) {
+            doNotOptimize(t.mExpireTime);
+        }
+    });
+
+    bench("iterate reverse", n, [&] {
+        for (Timer &t: std::views::reverse(tree)) {
+            doNotOptimize(t.mExpireTime);
+        }
+    });
+
+    bench("traversalInorder", n, [&] {
+        tree.traversalInorder([](Timer &t) { doNotOptimize(t.mExpireTime); });
+    });
+
+    // 模拟定时器循环：取出最早的定时器，再以更晚的时间重新加入
+    bench("pop_front+insert", times, [&] {
+        for (std::size_t i = 0; i < times; ++i) {
+            Timer &t = tree.pop_front();
+            t.mExpireTime += static_cast<std::int64_t>(rng() % (n * 16));
+            tree.insert(t);
+        }
+    });
+
+    bench("pop_front", n, [&] {
+        while (!tree.empty()) {
+            doNotOptimize(tree.pop_front().mExpireTime);
+        }
+    });
+
+    // 从有序输入恢复索引：逐个插入与线性建树对比
+    for (std::size_t i = 0; i < n; ++i) {
+        timers[i].mExpireTime = static_cast<std::int64_t>(i);
+    }
+
+    bench("insert sorted", n, [&] {
+        for (auto &t: timers) {
+            tree.insert(t);
+        }
+    });
+
+    bench("clear", n, [&] { tree.clear(); });
+
+    bench("assign_sorted", n, [&] { tree.assign_sorted(timers); });
+
+    bench("iterate built", n, [&] {
+        for (Timer &t: tree) {
+            doNotOptimize(t.mExpireTime);
+        }
+    });
+
+    // 在随机位置拆出一段再接回，代价与移动的结点数无关
+    TimerTree lower;
+    std::size_t rounds = 1000000;
+    bench("split+join", rounds, [&] {
+        for (std::size_t i = 0; i < rounds; ++i) {
+            Timer key;
+            key.mExpireTime = static_cast<std::int64_t>(rng() % n);
+            tree.split(key, lower, tree);
+            tree.join(lower, tree);
+        }
+    });
+
+    tree.clear();
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <rcu_map.hpp>
+
+// 互斥锁保护的 std::map，作为对照
+struct MutexMap {
+    std::mutex mutex;
+    std::map<std::uint64_t, std::uint64_t> map;
+
+    bool get(std::uint64_t key, std::uint64_t &value) {
+        std::lock_guard lock(mutex);
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    void insert_or_assign(std::uint64_t key, std::uint64_t value) {
+        std::lock_guard lock(mutex);
+        map.insert_or_assign(key, value);
+    }
+};
+
+struct RcuMapAdaptor {
+    RcuMap<std::uint64_t, std::uint64_t> map;
+
+    bool get(std::uint64_t key, std::uint64_t &value) {
+        auto guard = map.read();
+        if (auto const *found = guard.find(key)) {
+            value = *found;
+            return true;
+        }
+        return false;
+    }
+
+    void insert_or_assign(std::uint64_t key, std::uint64_t value) {
+        map.insert_or_assign(key, value);
+    }
+};
+
+// 模拟路由表：readers 个线程不停查找，一个写线程每毫秒更新一次
+// 每个读线程完成 lookups 次查找，报告总吞吐
+template <class Map>
+void bench(char const *name, std::size_t n, std::size_t readers,
+           std::size_t lookups) {
+    Map map;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        map.insert_or_assign(i * 2, i);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> writes{0};
+    std::thread writer([&] {
+        std::mt19937_64 rng(1);
+        while (!stop.load(std::memory_order_relaxed)) {
+            map.insert_or_assign((rng() % n) * 2, rng());
+            writes.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::atomic<std::size_t> hits{0};
+    std::vector<std::thread> threads;
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            std::mt19937_64 rng(42 + r);
+            std::size_t found = 0;
+            std::uint64_t value;
+            for (std::size_t i = 0; i < lookups; ++i) {
+                found += map.get(rng() % (n * 2), value);
+            }
+            hits.fetch_add(found, std::memory_order_relaxed);
+        });
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    stop.store(true, std::memory_order_relaxed);
+    writer.join();
+
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("%-10s %3zu readers %12.2f Mlookup/s  %6zu writes  hit %.2f\n",
+                name, readers, readers * lookups / s / 1e6, writes.load(),
+                double(hits.load()) / double(readers * lookups));
+}
+
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                   : 2000000;
+    std::size_t cores = std::thread::hardware_concurrency();
+    if (cores == 0) {
+        cores = 1;
+    }
+
+    for (std::size_t readers = 1; readers <= cores; readers *= 2) {
+        bench<MutexMap>("mutex", n, readers, lookups);
+        bench<RcuMapAdaptor>("RcuMap", n, readers, lookups);
+    }
+    return 0;
+}
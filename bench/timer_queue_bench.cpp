@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <rbtree.hpp>
+#include <pairing_heap.hpp>
+#include <dary_heap.hpp>
+
+template <class T>
+using RbTimerQueue = RbTree<T, std::less<T>, false>;
+
+template <class T>
+using PairingTimerQueue = PairingHeap<T>;
+
+template <class T>
+using DaryTimerQueue = DaryHeap<T>;
+
+template <template <class> class TimerQueue>
+struct Timer : TimerQueue<Timer<TimerQueue>>::Node {
+    std::int64_t mExpireTime;
+
+    friend bool operator<(Timer const &lhs, Timer const &rhs) noexcept {
+        return lhs.mExpireTime < rhs.mExpireTime;
+    }
+};
+
+// 模拟调度器的定时器负载：n 个定时器常驻，每轮以 1/4 的概率取消一个随机
+// 定时器并重新加入，否则取出最早到期的定时器并以更晚的时间重新加入
+template <template <class> class TimerQueue>
+void bench(char const *name, std::size_t n, std::size_t rounds) {
+    std::mt19937_64 rng(42);
+    std::vector<Timer<TimerQueue>> timers(n);
+    TimerQueue<Timer<TimerQueue>> queue;
+    std::int64_t now = 0;
+    std::size_t disorder = 0;
+
+    for (auto &t: timers) {
+        t.mExpireTime = static_cast<std::int64_t>(rng() % (n * 16));
+        queue.insert(t);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        auto r = rng();
+        if (r % 4 == 0) {
+            auto &t = timers[(r >> 8) % n];
+            queue.erase(t);
+            t.mExpireTime = now + static_cast<std::int64_t>((r >> 32) % (n * 16));
+            queue.insert(t);
+        } else {
+            auto &t = queue.pop_front();
+            disorder += t.mExpireTime < now;
+            now = t.mExpireTime;
+            t.mExpireTime = now + static_cast<std::int64_t>((r >> 32) % (n * 16));
+            queue.insert(t);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    while (!queue.empty()) {
+        queue.pop_front();
+    }
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-16s %10zu timers %10.2f ns/round  node %2zu bytes%s\n", name,
+                n, ns / rounds, sizeof(typename TimerQueue<Timer<TimerQueue>>::Node),
+                disorder ? "  OUT OF ORDER" : "");
+}
+
+int main(int argc, char **argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                  : 5000000;
+
+    bench<RbTimerQueue>("RbTree", n, rounds);
+    bench<PairingTimerQueue>("PairingHeap", n, rounds);
+    bench<DaryTimerQueue>("DaryHeap<4>", n, rounds);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <chrono>
+#include <tuple>
+#include <co_runtime.hpp>
+#include <debug.hpp>
+
+using namespace std::chrono_literals;
+
+// 与 src/main.cpp 相同的运行时，换用非默认的定时器容器：
+// 协程里的 sleep_for 须与运行它的 BasicLoop 使用同一个容器
+template <template <class> class TimerQueue>
+Task<int> hello1() {
+    debug(), "hello1开始睡1秒";
+    co_await sleep_for<TimerQueue>(1s); // 1s 等价于 std::chrono::seconds(1)
+    debug(), "hello1睡醒了";
+    co_return 1;
+}
+
+template <template <class> class TimerQueue>
+Task<int> hello2() {
+    debug(), "hello2开始睡2秒";
+    co_await sleep_for<TimerQueue>(2s); // 2s 等价于 std::chrono::seconds(2)
+    debug(), "hello2睡醒了";
+    co_return 2;
+}
+
+template <template <class> class TimerQueue>
+Task<int> hello() {
+    debug(), "hello开始等1和2";
+    auto v = co_await when_all(hello1<TimerQueue>(), hello2<TimerQueue>(),
+                               hello2<TimerQueue>());
+    co_return std::get<0>(v);
+}
+
+template <template <class> class TimerQueue>
+int runOn() {
+    auto t = hello<TimerQueue>();
+    getLoop<TimerQueue>().run(t);
+    return t.mCoroutine.promise().ReturnResult();
+}
+
+int main() {
+    debug(), "PairingHeap 上得到hello结果:", runOn<PairingTimerQueue>();
+    debug(), "DaryHeap 上得到hello结果:", runOn<DaryTimerQueue>();
+    return 0;
+}
@@ -0,0 +1,646 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// B+ 树有序表（非侵入式，键唯一）
+// 结点按缓存行对齐，每个结点容纳多个键，每层查找只触及一两条缓存行；
+// 叶子之间双向链接，顺序遍历不需回溯
+// 接口与 RbTree 一致：insert、erase、front、back、find、lower_bound、
+// upper_bound 和双向迭代器；迭代器解引用得到 Value&，键由 iterator::key() 取得
+// Key、Value 须可默认构造、可移动赋值；insert、erase 使所有迭代器失效
+template <class Key, class Value, class Compare = std::less<Key>,
+          std::size_t NodeBytes = 256>
+struct BTreeMap {
+private:
+    static constexpr std::size_t kCacheLine = 64;
+    static constexpr std::size_t kMaxDepth = 64;
+
+    struct NodeBase {
+        std::uint32_t count;
+        bool leaf;
+    };
+
+    // 叶子的键与值分开存放，结点内查找只扫描键数组
+    static constexpr std::size_t kLeafCap = std::max<std::size_t>(
+        4, (NodeBytes - sizeof(NodeBase) - 2 * sizeof(void *)) /
+               (sizeof(Key) + sizeof(Value)));
+    // 内部结点最多的键数，孩子数为键数加一
+    static constexpr std::size_t kInnerCap = std::max<std::size_t>(
+        4, (NodeBytes - sizeof(NodeBase) - sizeof(void *)) /
+               (sizeof(Key) + sizeof(void *)));
+    static constexpr std::size_t kLeafMin = kLeafCap / 2;
+    static constexpr std::size_t kInnerMin = kInnerCap / 2;
+
+    struct alignas(kCacheLine) Leaf : NodeBase {
+        Leaf() : NodeBase{0, true}, prev(nullptr), next(nullptr) {}
+
+        Leaf *prev;
+        Leaf *next;
+        Key keys[kLeafCap];
+        Value values[kLeafCap];
+    };
+
+    // children[i] 中的键均小于 keys[i]，children[i + 1] 中的键均不小于 keys[i]
+    struct alignas(kCacheLine) Inner : NodeBase {
+        Inner() : NodeBase{0, false} {}
+
+        Key keys[kInnerCap];
+        NodeBase *children[kInnerCap + 1];
+    };
+
+    struct PathEntry {
+        Inner *node;
+        std::size_t index;
+    };
+
+    NodeBase *root;
+    Leaf *leftmost;
+    Leaf *rightmost;
+    std::size_t count;
+    Compare comp;
+
+    template <class K>
+    static constexpr bool isKeyComparable =
+        std::is_same_v<K, Key> ||
+        requires { typename Compare::is_transparent; };
+
+    // 算术类型的键使用默认比较时，结点内改为无分支的线性计数，
+    // 编译器可将其向量化；其余情况二分查找
+    template <class K>
+    static constexpr bool isLinearSearch =
+        std::is_arithmetic_v<Key> && std::is_arithmetic_v<K> &&
+        (std::is_same_v<Compare, std::less<Key>> ||
+         std::is_same_v<Compare, std::less<>>);
+
+    // 结点内小于 key 的键的个数
+    template <class K>
+    std::size_t lowerIndex(Key const *keys, std::size_t n,
+                           K const &key) const noexcept {
+        if constexpr (isLinearSearch<K>) {
+            std::size_t index = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                index += keys[i] < key;
+            }
+            return index;
+        } else {
+            std::size_t lo = 0;
+            std::size_t hi = n;
+            while (lo < hi) {
+                std::size_t mid = (lo + hi) / 2;
+                if (comp(keys[mid], key)) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+    }
+
+    // 结点内不大于 key 的键的个数
+    template <class K>
+    std::size_t upperIndex(Key const *keys, std::size_t n,
+                           K const &key) const noexcept {
+        if constexpr (isLinearSearch<K>) {
+            std::size_t index = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                index += !(key < keys[i]);
+            }
+            return index;
+        } else {
+            std::size_t lo = 0;
+            std::size_t hi = n;
+            while (lo < hi) {
+                std::size_t mid = (lo + hi) / 2;
+                if (comp(key, keys[mid])) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            return lo;
+        }
+    }
+
+    // 沿不大于 key 的分隔键下降到叶子，可选记录路径；树不能为空
+    template <class K>
+    Leaf *descend(K const &key, PathEntry *path,
+                  std::size_t &depth) const noexcept {
+        NodeBase *node = root;
+        depth = 0;
+        while (!node->leaf) {
+            Inner *inner = static_cast<Inner *>(node);
+            std::size_t index = upperIndex(inner->keys, inner->count, key);
+            if (path != nullptr) {
+                path[depth] = {inner, index};
+            }
+            ++depth;
+            node = inner->children[index];
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    // 第一个不小于 key 的元素
+    // 下降时 key 不小于该叶子的下界分隔键，叶子内找不到时一定是下一个叶子的首元素
+    template <class K>
+    std::pair<Leaf *, std::size_t> doLowerBound(K const &key) const noexcept {
+        if (root == nullptr) {
+            return {nullptr, 0};
+        }
+        std::size_t depth;
+        Leaf *leaf = descend(key, nullptr, depth);
+        std::size_t index = lowerIndex(leaf->keys, leaf->count, key);
+        if (index == leaf->count) {
+            return {leaf->next, 0};
+        }
+        return {leaf, index};
+    }
+
+    template <class K>
+    std::pair<Leaf *, std::size_t> doUpperBound(K const &key) const noexcept {
+        if (root == nullptr) {
+            return {nullptr, 0};
+        }
+        std::size_t depth;
+        Leaf *leaf = descend(key, nullptr, depth);
+        std::size_t index = upperIndex(leaf->keys, leaf->count, key);
+        if (index == leaf->count) {
+            return {leaf->next, 0};
+        }
+        return {leaf, index};
+    }
+
+    static void insertAt(Leaf *leaf, std::size_t index, Key const &key,
+                         Value &&value) {
+        for (std::size_t i = leaf->count; i > index; --i) {
+            leaf->keys[i] = std::move(leaf->keys[i - 1]);
+            leaf->values[i] = std::move(leaf->values[i - 1]);
+        }
+        leaf->keys[index] = key;
+        leaf->values[index] = std::move(value);
+        ++leaf->count;
+    }
+
+    static void eraseAt(Leaf *leaf, std::size_t index) {
+        for (std::size_t i = index + 1; i < leaf->count; ++i) {
+            leaf->keys[i - 1] = std::move(leaf->keys[i]);
+            leaf->values[i - 1] = std::move(leaf->values[i]);
+        }
+        --leaf->count;
+    }
+
+    // 把 from 的 [first, last) 移到 to 的末尾
+    static void moveEntries(Leaf *from, std::size_t first, std::size_t last,
+                            Leaf *to) {
+        for (std::size_t i = first; i < last; ++i) {
+            to->keys[to->count] = std::move(from->keys[i]);
+            to->values[to->count] = std::move(from->values[i]);
+            ++to->count;
+        }
+    }
+
+    // 在 leaf 之后插入新叶子并维护链表
+    void linkAfter(Leaf *leaf, Leaf *right) noexcept {
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next != nullptr) {
+            leaf->next->prev = right;
+        } else {
+            rightmost = right;
+        }
+        leaf->next = right;
+    }
+
+    // 结点分裂后把分隔键和新的右结点逐层插入父结点，必要时继续分裂
+    void insertParent(PathEntry *path, std::size_t depth, Key separator,
+                      NodeBase *child) {
+        while (depth > 0) {
+            auto [inner, index] = path[--depth];
+            if (inner->count < kInnerCap) {
+                for (std::size_t i = inner->count; i > index; --i) {
+                    inner->keys[i] = std::move(inner->keys[i - 1]);
+                    inner->children[i + 1] = inner->children[i];
+                }
+                inner->keys[index] = std::move(separator);
+                inner->children[index + 1] = child;
+                ++inner->count;
+                return;
+            }
+
+            // 合并到临时数组后对半分，中间的键上移
+            Key keys[kInnerCap + 1];
+            NodeBase *children[kInnerCap + 2];
+            for (std::size_t i = 0, j = 0; i <= kInnerCap; ++i) {
+                keys[i] = i == index ? std::move(separator)
+                                     : std::move(inner->keys[j++]);
+            }
+            for (std::size_t i = 0, j = 0; i <= kInnerCap + 1; ++i) {
+                children[i] = i == index + 1 ? child : inner->children[j++];
+            }
+
+            constexpr std::size_t mid = (kInnerCap + 1) / 2;
+            Inner *right = new Inner();
+            inner->count = mid;
+            for (std::size_t i = 0; i < mid; ++i) {
+                inner->keys[i] = std::move(keys[i]);
+                inner->children[i] = children[i];
+            }
+            inner->children[mid] = children[mid];
+            for (std::size_t i = mid + 1; i <= kInnerCap; ++i) {
+                right->keys[right->count] = std::move(keys[i]);
+                right->children[right->count] = children[i];
+                ++right->count;
+            }
+            right->children[right->count] = children[kInnerCap + 1];
+
+            separator = std::move(keys[mid]);
+            child = right;
+        }
+
+        Inner *newRoot = new Inner();
+        newRoot->count = 1;
+        newRoot->keys[0] = std::move(separator);
+        newRoot->children[0] = root;
+        newRoot->children[1] = child;
+        root = newRoot;
+    }
+
+    std::pair<Leaf *, std::size_t> doInsert(Key const &key, Value &&value,
+                                            bool &inserted) {
+        if (root == nullptr) {
+            Leaf *leaf = new Leaf();
+            root = leftmost = rightmost = leaf;
+        }
+
+        PathEntry path[kMaxDepth];
+        std::size_t depth;
+        Leaf *leaf = descend(key, path, depth);
+        std::size_t index = lowerIndex(leaf->keys, leaf->count, key);
+        if (index < leaf->count && !comp(key, leaf->keys[index])) {
+            inserted = false;
+            return {leaf, index};
+        }
+        inserted = true;
+
+        if (leaf->count < kLeafCap) {
+            insertAt(leaf, index, key, std::move(value));
+            ++count;
+            return {leaf, index};
+        }
+
+        // 叶子已满：分裂成两半，新元素落在所属的一半
+        constexpr std::size_t mid = (kLeafCap + 1) / 2;
+        Leaf *right = new Leaf();
+        linkAfter(leaf, right);
+        std::pair<Leaf *, std::size_t> result;
+        if (index < mid) {
+            moveEntries(leaf, mid - 1, kLeafCap, right);
+            leaf->count = mid - 1;
+            insertAt(leaf, index, key, std::move(value));
+            result = {leaf, index};
+        } else {
+            moveEntries(leaf, mid, kLeafCap, right);
+            leaf->count = mid;
+            insertAt(right, index - mid, key, std::move(value));
+            result = {right, index - mid};
+        }
+        ++count;
+        insertParent(path, depth, right->keys[0], right);
+        return result;
+    }
+
+    // 删除父结点的第 index 个键及其右侧的孩子
+    static void removeChild(Inner *node, std::size_t index) noexcept {
+        for (std::size_t i = index + 1; i < node->count; ++i) {
+            node->keys[i - 1] = std::move(node->keys[i]);
+            node->children[i] = node->children[i + 1];
+        }
+        --node->count;
+    }
+
+    // 把 right 并入 left 并释放 right
+    void mergeLeaf(Leaf *left, Leaf *right) {
+        moveEntries(right, 0, right->count, left);
+        left->next = right->next;
+        if (right->next != nullptr) {
+            right->next->prev = left;
+        } else {
+            rightmost = left;
+        }
+        delete right;
+    }
+
+    void mergeInner(Inner *left, Key &separator, Inner *right) {
+        left->keys[left->count] = std::move(separator);
+        for (std::size_t i = 0; i < right->count; ++i) {
+            left->keys[left->count + 1 + i] = std::move(right->keys[i]);
+            left->children[left->count + 1 + i] = right->children[i];
+        }
+        left->children[left->count + 1 + right->count] =
+            right->children[right->count];
+        left->count += 1 + right->count;
+        delete right;
+    }
+
+    // 叶子不足半满：先向左右兄弟借一个元素，借不到则与兄弟合并
+    // 返回 true 表示发生了合并，父结点少了一个键
+    bool fixLeaf(Leaf *leaf, Inner *parent, std::size_t index) {
+        Leaf *left = index > 0 ? static_cast<Leaf *>(parent->children[index - 1])
+                               : nullptr;
+        Leaf *right = index < parent->count
+                          ? static_cast<Leaf *>(parent->children[index + 1])
+                          : nullptr;
+        if (left != nullptr && left->count > kLeafMin) {
+            insertAt(leaf, 0, left->keys[left->count - 1],
+                     std::move(left->values[left->count - 1]));
+            --left->count;
+            parent->keys[index - 1] = leaf->keys[0];
+            return false;
+        }
+        if (right != nullptr && right->count > kLeafMin) {
+            moveEntries(right, 0, 1, leaf);
+            eraseAt(right, 0);
+            parent->keys[index] = right->keys[0];
+            return false;
+        }
+        if (left != nullptr) {
+            mergeLeaf(left, leaf);
+            removeChild(parent, index - 1);
+        } else {
+            mergeLeaf(leaf, right);
+            removeChild(parent, index);
+        }
+        return true;
+    }
+
+    // 内部结点不足半满：经由父结点的分隔键向兄弟借一个孩子，借不到则合并
+    bool fixInner(Inner *node, Inner *parent, std::size_t index) {
+        Inner *left = index > 0
+                          ? static_cast<Inner *>(parent->children[index - 1])
+                          : nullptr;
+        Inner *right = index < parent->count
+                           ? static_cast<Inner *>(parent->children[index + 1])
+                           : nullptr;
+        if (left != nullptr && left->count > kInnerMin) {
+            node->children[node->count + 1] = node->children[node->count];
+            for (std::size_t i = node->count; i > 0; --i) {
+                node->keys[i] = std::move(node->keys[i - 1]);
+                node->children[i] = node->children[i - 1];
+            }
+            node->keys[0] = std::move(parent->keys[index - 1]);
+            node->children[0] = left->children[left->count];
+            ++node->count;
+            parent->keys[index - 1] = std::move(left->keys[left->count - 1]);
+            --left->count;
+            return false;
+        }
+        if (right != nullptr && right->count > kInnerMin) {
+            node->keys[node->count] = std::move(parent->keys[index]);
+            node->children[node->count + 1] = right->children[0];
+            ++node->count;
+            parent->keys[index] = std::move(right->keys[0]);
+            right->children[0] = right->children[1];
+            removeChild(right, 0);
+            return false;
+        }
+        if (left != nullptr) {
+            mergeInner(left, parent->keys[index - 1], node);
+            removeChild(parent, index - 1);
+        } else {
+            mergeInner(node, parent->keys[index], right);
+            removeChild(parent, index);
+        }
+        return true;
+    }
+
+    template <class K>
+    std::size_t doErase(K const &key) {
+        if (root == nullptr) {
+            return 0;
+        }
+        PathEntry path[kMaxDepth];
+        std::size_t depth;
+        Leaf *leaf = descend(key, path, depth);
+        std::size_t index = lowerIndex(leaf->keys, leaf->count, key);
+        if (index == leaf->count || comp(key, leaf->keys[index])) {
+            return 0;
+        }
+        eraseAt(leaf, index);
+        --count;
+
+        if (depth == 0) {
+            if (leaf->count == 0) {
+                delete leaf;
+                root = leftmost = rightmost = nullptr;
+            }
+            return 1;
+        }
+        if (leaf->count >= kLeafMin) {
+            return 1;
+        }
+
+        // 自底向上修复，根只剩一个孩子时树高减一
+        bool merged = fixLeaf(leaf, path[depth - 1].node, path[depth - 1].index);
+        std::size_t level = depth - 1;
+        while (merged) {
+            Inner *node = path[level].node;
+            if (level == 0) {
+                if (node->count == 0) {
+                    root = node->children[0];
+                    delete node;
+                }
+                break;
+            }
+            if (node->count >= kInnerMin) {
+                break;
+            }
+            merged = fixInner(node, path[level - 1].node, path[level - 1].index);
+            --level;
+        }
+        return 1;
+    }
+
+    static void doClear(NodeBase *node) noexcept {
+        if (node->leaf) {
+            delete static_cast<Leaf *>(node);
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        for (std::size_t i = 0; i <= inner->count; ++i) {
+            doClear(inner->children[i]);
+        }
+        delete inner;
+    }
+
+public:
+    struct iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        iterator() noexcept : leaf(nullptr), index(0), tree(nullptr) {}
+
+        Value &operator*() const noexcept {
+            return leaf->values[index];
+        }
+
+        Value *operator->() const noexcept {
+            return &leaf->values[index];
+        }
+
+        Key const &key() const noexcept {
+            return leaf->keys[index];
+        }
+
+        iterator &operator++() noexcept {
+            if (++index == leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        // end() 自减得到最后一个元素
+        iterator &operator--() noexcept {
+            if (leaf == nullptr) {
+                leaf = tree->rightmost;
+                index = leaf->count - 1;
+            } else if (index == 0) {
+                leaf = leaf->prev;
+                index = leaf->count - 1;
+            } else {
+                --index;
+            }
+            return *this;
+        }
+
+        iterator operator--(int) noexcept {
+            iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(iterator const &lhs,
+                               iterator const &rhs) noexcept {
+            return lhs.leaf == rhs.leaf && lhs.index == rhs.index;
+        }
+
+        friend struct BTreeMap;
+
+    private:
+        iterator(Leaf *leaf, std::size_t index, BTreeMap const *tree) noexcept
+            : leaf(leaf),
+              index(index),
+              tree(tree) {}
+
+        Leaf *leaf;
+        std::size_t index;
+        BTreeMap const *tree;
+    };
+
+    BTreeMap() noexcept
+        : root(nullptr),
+          leftmost(nullptr),
+          rightmost(nullptr),
+          count(0) {}
+
+    explicit BTreeMap(Compare comp) noexcept(noexcept(Compare(comp)))
+        : root(nullptr),
+          leftmost(nullptr),
+          rightmost(nullptr),
+          count(0),
+          comp(comp) {}
+
+    BTreeMap(BTreeMap &&) = delete;
+
+    ~BTreeMap() noexcept {
+        clear();
+    }
+
+    // 键已存在时不覆盖，返回已有元素的迭代器和 false
+    std::pair<iterator, bool> insert(Key const &key, Value value) {
+        bool inserted;
+        auto [leaf, index] = doInsert(key, std::move(value), inserted);
+        return {iterator(leaf, index, this), inserted};
+    }
+
+    // 返回删除的元素个数（0 或 1）
+    template <class K>
+        requires isKeyComparable<K>
+    std::size_t erase(K const &key) {
+        return doErase(key);
+    }
+
+    bool empty() const noexcept {
+        return root == nullptr;
+    }
+
+    std::size_t size() const noexcept {
+        return count;
+    }
+
+    // 最小、最大元素，树不能为空
+    Value &front() const noexcept {
+        return leftmost->values[0];
+    }
+
+    Value &back() const noexcept {
+        return rightmost->values[rightmost->count - 1];
+    }
+
+    void clear() noexcept {
+        if (root != nullptr) {
+            doClear(root);
+        }
+        root = leftmost = rightmost = nullptr;
+        count = 0;
+    }
+
+    iterator begin() const noexcept {
+        return iterator(leftmost, 0, this);
+    }
+
+    iterator end() const noexcept {
+        return iterator(nullptr, 0, this);
+    }
+
+    // 查找接口均返回 end() 表示不存在
+    template <class K>
+        requires isKeyComparable<K>
+    iterator find(K const &key) const noexcept {
+        auto [leaf, index] = doLowerBound(key);
+        if (leaf == nullptr || comp(key, leaf->keys[index])) {
+            return end();
+        }
+        return iterator(leaf, index, this);
+    }
+
+    template <class K>
+        requires isKeyComparable<K>
+    iterator lower_bound(K const &key) const noexcept {
+        auto [leaf, index] = doLowerBound(key);
+        return iterator(leaf, index, this);
+    }
+
+    template <class K>
+        requires isKeyComparable<K>
+    iterator upper_bound(K const &key) const noexcept {
+        auto [leaf, index] = doUpperBound(key);
+        return iterator(leaf, index, this);
+    }
+};
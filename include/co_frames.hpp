@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 协程帧登记（CO_FRAMES 时启用，否则 promise 不带登记项，也不调用这里的函数）
+// 启用后运行时的 promise 各带一个 Record 挂在全局链表上，
+// 记录帧大小、协程函数位置和最近一次挂起的时刻，
+// 由此可以按协程函数统计存活的帧数、总字节数与挂起最久的时长，
+// 找出落败后没被销毁的 when_any 子任务、被遗忘的 sleep 之类的泄漏
+struct CoFrames {
+    // 嵌在 promise 中的登记项，get_return_object 时挂到链表，析构时摘除
+    // 不依赖协程帧的分配方式：编译器省去了堆分配的帧（例如 Clang 的 HALO）
+    // 照样登记，只是没有经过 allocate，大小记为 0
+    struct Record {
+        Record() noexcept = default;
+        Record(Record &&) = delete;
+
+        ~Record() {
+            if (mPrev) {
+                unlink(*this);
+            }
+        }
+
+    private:
+        friend CoFrames;
+
+        Record *mPrev = nullptr;
+        Record *mNext = nullptr;
+        char const *mFunction = nullptr;
+        char const *mFile = nullptr;
+        std::uint_least32_t mLine = 0;
+        // 协程帧的堆上字节数
+        std::size_t mSize = 0;
+        // 最近一次挂起的 steady_clock 纳秒，创建时即处于挂起
+        // 只由协程自己的线程写，汇总时读，不需要加锁
+        std::atomic<std::uint64_t> mSuspended{0};
+    };
+
+private:
+    struct State {
+        std::mutex mMutex;
+        // 哨兵结点，链表为环形
+        Record mHead;
+        std::size_t mFrames = 0;
+        std::size_t mBytes = 0;
+
+        State() {
+            mHead.mPrev = &mHead;
+            mHead.mNext = &mHead;
+        }
+    };
+
+    // 有意不析构：静态对象析构期间仍可能有协程帧被销毁
+    static State &global() {
+        static State *state = new State;
+        return *state;
+    }
+
+    // allocate 到紧随其后的 create 之间传递帧大小；帧的分配被省去时保持为 0
+    static std::size_t &allocatedSize() noexcept {
+        static thread_local std::size_t size = 0;
+        return size;
+    }
+
+    static void unlink(Record &record) noexcept {
+        State &g = global();
+        std::lock_guard lock(g.mMutex);
+        record.mPrev->mNext = record.mNext;
+        record.mNext->mPrev = record.mPrev;
+        --g.mFrames;
+        g.mBytes -= record.mSize;
+    }
+
+    static std::uint64_t now() noexcept {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+public:
+    // 按协程函数（源码位置）汇总的存活帧
+    // GCC 中 mLine 是协程函数体结束的那一行
+    struct Usage {
+        char const *mFunction;
+        char const *mFile;
+        std::uint_least32_t mLine;
+        std::size_t mFrames;
+        std::size_t mBytes;
+        std::chrono::nanoseconds mOldestSuspended;
+    };
+
+    // 供 promise 的 operator new / operator delete 调用，只为记下帧大小
+    static void *allocate(std::size_t size) {
+        void *frame = ::operator new(size);
+        allocatedSize() = size;
+        return frame;
+    }
+
+    static void deallocate(void *frame, std::size_t size) noexcept {
+        ::operator delete(frame, size);
+    }
+
+    // 协程帧创建，loc 为协程函数的位置（在 get_return_object 的默认参数中取得）
+    static void create(Record &record, std::source_location const &loc) noexcept {
+        record.mFunction = loc.function_name();
+        record.mFile = loc.file_name();
+        record.mLine = loc.line();
+        record.mSize = std::exchange(allocatedSize(), 0);
+        record.mSuspended.store(now(), std::memory_order_relaxed);
+        State &g = global();
+        std::lock_guard lock(g.mMutex);
+        record.mPrev = &g.mHead;
+        record.mNext = g.mHead.mNext;
+        g.mHead.mNext->mPrev = &record;
+        g.mHead.mNext = &record;
+        ++g.mFrames;
+        g.mBytes += record.mSize;
+    }
+
+    // 协程即将在 co_await 处挂起
+    static void suspend(Record &record) noexcept {
+        record.mSuspended.store(now(), std::memory_order_relaxed);
+    }
+
+    // 存活的帧数与总字节数
+    static std::pair<std::size_t, std::size_t> totals() {
+        State &g = global();
+        std::lock_guard lock(g.mMutex);
+        return {g.mFrames, g.mBytes};
+    }
+
+    // 按总字节数从大到小排列的汇总
+    static std::vector<Usage> usage() {
+        struct Key {
+            std::string_view mFile;
+            std::uint_least32_t mLine;
+
+            bool operator==(Key const &) const = default;
+        };
+        struct Hash {
+            std::size_t operator()(Key const &key) const noexcept {
+                return std::hash<std::string_view>()(key.mFile) ^
+                       (std::size_t(key.mLine) * 0x9e3779b97f4a7c15u);
+            }
+        };
+        std::uint64_t time = now();
+        std::unordered_map<Key, Usage, Hash> groups;
+        {
+            State &g = global();
+            std::lock_guard lock(g.mMutex);
+            for (Record *h = g.mHead.mNext; h != &g.mHead; h = h->mNext) {
+                Key key{h->mFile ? h->mFile : "", h->mLine};
+                auto [it, inserted] = groups.try_emplace(
+                    key, Usage{h->mFunction, h->mFile, h->mLine, 0, 0, {}});
+                Usage &u = it->second;
+                ++u.mFrames;
+                u.mBytes += h->mSize;
+                std::uint64_t suspended =
+                    h->mSuspended.load(std::memory_order_relaxed);
+                auto age = std::chrono::nanoseconds(
+                    time > suspended ? time - suspended : 0);
+                u.mOldestSuspended = std::max(u.mOldestSuspended, age);
+            }
+        }
+        std::vector<Usage> result;
+        result.reserve(groups.size());
+        for (auto &[key, u]: groups) {
+            result.push_back(u);
+        }
+        std::sort(result.begin(), result.end(),
+                  [](Usage const &lhs, Usage const &rhs) {
+                      return lhs.mBytes != rhs.mBytes ? lhs.mBytes > rhs.mBytes
+                                                      : lhs.mFrames > rhs.mFrames;
+                  });
+        return result;
+    }
+
+    // 输出占用最多的前 top 个协程函数
+    static void writeTop(std::ostream &out, std::size_t top = 10) {
+        auto [frames, bytes] = totals();
+        std::vector<Usage> all = usage();
+        out << "coroutine frames: " << frames << " live, " << bytes
+            << " bytes\n";
+        out << std::setw(8) << "frames" << std::setw(12) << "bytes"
+            << std::setw(16) << "suspended(ms)" << "  function\n";
+        for (std::size_t i = 0; i < all.size() && i < top; ++i) {
+            Usage const &u = all[i];
+            out << std::setw(8) << u.mFrames << std::setw(12) << u.mBytes
+                << std::setw(16)
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                       u.mOldestSuspended)
+                       .count()
+                << "  " << (u.mFunction ? u.mFunction : "<unknown>");
+            if (u.mFile) {
+                out << " (" << u.mFile << ':' << u.mLine << ')';
+            }
+            out << '\n';
+        }
+    }
+};
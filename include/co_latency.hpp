@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#if (defined(__x86_64__) || defined(__i386__)) && __has_include(<x86intrin.h>)
+#include <x86intrin.h>
+#define CO_LATENCY_TSC 1
+#endif
+
+// 调度延迟统计（CO_LATENCY 为 0 时 Loop 不记录，默认开启）
+// Loop 每轮调度只读一次时钟，入队与出队都用这一轮的时间戳，每个协程只多一次直方图记录
+#ifndef CO_LATENCY
+#define CO_LATENCY 1
+#endif
+
+// 对数-线性直方图（HDR 风格），记录纳秒值
+// 每个 2 的幂区间再等分为 32 格，相对误差不超过 1/32，
+// 覆盖整个 uint64 范围，记录只是一次 bit_width 和几次加法，不分配内存
+// 非线程安全，由所属 Loop 的线程记录与读取
+struct LatencyHistogram {
+private:
+    static constexpr unsigned kSubBits = 5;
+    static constexpr std::uint64_t kSubCount = std::uint64_t(1) << kSubBits;
+    static constexpr std::size_t kBucketCount =
+        (64 - kSubBits - 1) * kSubCount + 2 * kSubCount;
+
+    std::array<std::uint64_t, kBucketCount> mCounts{};
+    std::uint64_t mTotal = 0;
+    std::uint64_t mMax = 0;
+
+    // 小于 2*kSubCount 的值各占一格；更大的值按最高位所在区间分组，
+    // 组内取最高位以下的 kSubBits 位
+    static std::size_t indexOf(std::uint64_t value) noexcept {
+        unsigned width = static_cast<unsigned>(std::bit_width(value));
+        unsigned shift = width > kSubBits + 1 ? width - kSubBits - 1 : 0;
+        return shift * kSubCount + (value >> shift);
+    }
+
+    // 第 index 格能表示的最大值
+    static std::uint64_t highestOf(std::size_t index) noexcept {
+        if (index < 2 * kSubCount) {
+            return index;
+        }
+        unsigned shift = static_cast<unsigned>(index / kSubCount - 1);
+        std::uint64_t lowest = (index % kSubCount + kSubCount) << shift;
+        return lowest + ((std::uint64_t(1) << shift) - 1);
+    }
+
+    static void writeNanos(std::ostream &out, std::uint64_t ns) {
+        if (ns < 10000) {
+            out << ns << "ns";
+        } else if (ns < 10000000) {
+            out << ns / 1000 << "us";
+        } else {
+            out << ns / 1000000 << "ms";
+        }
+    }
+
+public:
+    void record(std::uint64_t ns) noexcept {
+        ++mCounts[indexOf(ns)];
+        ++mTotal;
+        mMax = std::max(mMax, ns);
+    }
+
+    void record(std::chrono::nanoseconds duration) noexcept {
+        record(static_cast<std::uint64_t>(
+            std::max<std::chrono::nanoseconds::rep>(duration.count(), 0)));
+    }
+
+    std::uint64_t count() const noexcept {
+        return mTotal;
+    }
+
+    std::uint64_t max() const noexcept {
+        return mMax;
+    }
+
+    // 第 q 分位（0 < q <= 1）的上界，没有记录时为 0
+    std::uint64_t percentile(double q) const noexcept {
+        if (mTotal == 0) {
+            return 0;
+        }
+        // 最近秩：不小于 q * mTotal 的最小整数；
+        // 先减去一点相对误差，免得 0.07 * 100 之类略大于整数的乘积多进一位
+        double exact = q * static_cast<double>(mTotal);
+        auto rank = static_cast<std::uint64_t>(
+            std::max(std::ceil(exact - exact * 1e-12), 0.0));
+        rank = std::clamp<std::uint64_t>(rank, 1, mTotal);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            seen += mCounts[i];
+            if (seen >= rank) {
+                return std::min(highestOf(i), mMax);
+            }
+        }
+        return mMax;
+    }
+
+    void merge(LatencyHistogram const &other) noexcept {
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            mCounts[i] += other.mCounts[i];
+        }
+        mTotal += other.mTotal;
+        mMax = std::max(mMax, other.mMax);
+    }
+
+    void reset() noexcept {
+        mCounts.fill(0);
+        mTotal = 0;
+        mMax = 0;
+    }
+
+    // 一行摘要：name n=... p50=... p99=... p999=... max=...
+    void writeText(std::ostream &out, std::string_view name) const {
+        out << name << " n=" << mTotal << " p50=";
+        writeNanos(out, percentile(0.5));
+        out << " p99=";
+        writeNanos(out, percentile(0.99));
+        out << " p999=";
+        writeNanos(out, percentile(0.999));
+        out << " max=";
+        writeNanos(out, mMax);
+        out << '\n';
+    }
+};
+
+// 就绪等待用的廉价时间戳：x86 上读 TSC，构造时对照 steady_clock 校准约 200us，
+// 由 Loop 在构造时完成，不会在第一次记录时才忙等；其它平台直接取 steady_clock 的纳秒数
+struct LatencyClock {
+private:
+#if CO_LATENCY_TSC
+    static double calibrate() noexcept {
+        auto t0 = std::chrono::steady_clock::now();
+        std::uint64_t c0 = __rdtsc();
+        std::chrono::steady_clock::time_point t1;
+        do {
+            t1 = std::chrono::steady_clock::now();
+        } while (t1 - t0 < std::chrono::microseconds(200));
+        std::uint64_t c1 = __rdtsc();
+        auto ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return c1 > c0 ? ns / static_cast<double>(c1 - c0) : 1.0;
+    }
+
+    double mNanosPerTick = calibrate();
+#endif
+
+public:
+    static std::uint64_t now() noexcept {
+#if CO_LATENCY_TSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+#endif
+    }
+
+    // 两次 now() 之间的纳秒数，时间戳倒退时为 0
+    std::uint64_t nanosBetween(std::uint64_t from,
+                               std::uint64_t to) const noexcept {
+        if (to <= from) {
+            return 0;
+        }
+#if CO_LATENCY_TSC
+        return static_cast<std::uint64_t>(static_cast<double>(to - from) *
+                                          mNanosPerTick);
+#else
+        return to - from;
+#endif
+    }
+};
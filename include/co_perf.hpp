@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifndef CO_PERF_EVENTS
+#if __has_include(<linux/perf_event.h>) && __has_include(<sys/syscall.h>) && \
+    __has_include(<sys/ioctl.h>) && __has_include(<unistd.h>)
+#define CO_PERF_EVENTS 1
+#else
+#define CO_PERF_EVENTS 0
+#endif
+#endif
+
+#if CO_PERF && CO_PERF_EVENTS
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 协程 CPU 开销统计（CO_PERF 时启用，否则各记录函数为空操作）
+// Loop 每次 resume() 前后读取本线程的计数器，差值记到被恢复协程所属的根任务上，
+// 再按根任务的协程函数汇总，不借助外部 profiler 就能看出哪个处理函数在两次挂起之间耗 CPU
+// 根任务是不在任何 Loop 恢复过程中创建的协程（例如传给 run() 的任务），
+// 在某个根任务执行期间创建的协程都归属于它
+// 计数器优先用 perf_event_open（task-clock、cycles、instructions、cache-misses，
+// 打不开的硬件计数器记为不可用），整个不可用时退回 CLOCK_THREAD_CPUTIME_ID，只统计 CPU 时间
+// 统计按线程分开，usage/writeTop 返回调用线程（即运行 Loop 的线程）的数据
+struct CoPerf {
+    enum Counter : std::size_t {
+        kCpuNanos,
+        kCycles,
+        kInstructions,
+        kCacheMisses,
+        kCounterCount,
+    };
+
+    using Sample = std::array<std::uint64_t, kCounterCount>;
+
+    // 一个根任务协程函数的累计开销
+    struct Usage {
+        char const *mFunction;
+        std::uint64_t mResumes;
+        Sample mTotals;
+    };
+
+private:
+    struct Counters {
+        bool mAvailable[kCounterCount]{};
+#if CO_PERF && CO_PERF_EVENTS
+        // 组内各计数器依次对应的 Counter，mFds[0] 为组长
+        int mFds[kCounterCount]{-1, -1, -1, -1};
+        Counter mOrder[kCounterCount]{};
+        std::size_t mCount = 0;
+
+        int open(std::uint32_t type, std::uint64_t config, int group) noexcept {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = group == -1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            return static_cast<int>(
+                ::syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+        }
+
+        void add(Counter counter, std::uint32_t type, std::uint64_t config) {
+            int fd = open(type, config, mCount == 0 ? -1 : mFds[0]);
+            if (fd < 0) {
+                return;
+            }
+            mFds[mCount] = fd;
+            mOrder[mCount] = counter;
+            ++mCount;
+            mAvailable[counter] = true;
+        }
+
+        Counters() {
+            add(kCpuNanos, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+            if (mCount == 0) {
+                mAvailable[kCpuNanos] = true;
+                return;
+            }
+            add(kCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            add(kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            add(kCacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            ::ioctl(mFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        Counters(Counters &&) = delete;
+
+        ~Counters() {
+            for (std::size_t i = 0; i < mCount; ++i) {
+                ::close(mFds[i]);
+            }
+        }
+#else
+        Counters() {
+            mAvailable[kCpuNanos] = true;
+        }
+#endif
+
+        Sample read() const noexcept {
+            Sample sample{};
+#if CO_PERF && CO_PERF_EVENTS
+            if (mCount != 0) {
+                // PERF_FORMAT_GROUP：个数，随后按加入顺序排列的各计数值
+                std::uint64_t buffer[1 + kCounterCount];
+                if (::read(mFds[0], buffer, sizeof(buffer)) > 0) {
+                    for (std::size_t i = 0; i < mCount && i < buffer[0]; ++i) {
+                        sample[mOrder[i]] = buffer[1 + i];
+                    }
+                }
+                return sample;
+            }
+#endif
+            timespec ts{};
+            ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+            sample[kCpuNanos] = static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u +
+                                static_cast<std::uint64_t>(ts.tv_nsec);
+            return sample;
+        }
+    };
+
+    struct State {
+        Counters mCounters;
+        // 存活的帧地址 -> 所属根任务的协程函数名，帧销毁时删除
+        std::unordered_map<void const *, char const *> mRoots;
+        // 正在由 Loop 恢复的根任务，不在恢复过程中时为空
+        char const *mCurrentRoot = nullptr;
+        std::unordered_map<char const *, Usage> mUsage;
+    };
+
+    [[maybe_unused]] static State &local() {
+        static thread_local State state;
+        return state;
+    }
+
+public:
+    // 协程帧创建，loc 为协程函数的位置（在 get_return_object 的默认参数中取得）
+    static void create([[maybe_unused]] void const *frame,
+                       [[maybe_unused]] std::source_location const &loc) noexcept {
+#if CO_PERF
+        State &s = local();
+        try {
+            s.mRoots[frame] =
+                s.mCurrentRoot ? s.mCurrentRoot : loc.function_name();
+        } catch (...) {
+        }
+#endif
+    }
+
+    // 协程帧销毁，由 promise 的析构函数调用
+    static void destroy([[maybe_unused]] void const *frame) noexcept {
+#if CO_PERF
+        local().mRoots.erase(frame);
+#endif
+    }
+
+    // Loop 恢复协程期间的作用域：构造时采样，析构时把差值记到根任务上
+    struct Resume {
+#if CO_PERF
+        State &mState;
+        char const *mRoot;
+        char const *mPreviousRoot;
+        Sample mStart;
+
+        explicit Resume(void const *frame) noexcept
+            : mState(local()), mPreviousRoot(mState.mCurrentRoot) {
+            auto it = mState.mRoots.find(frame);
+            mRoot = it != mState.mRoots.end() ? it->second : "<unknown>";
+            mState.mCurrentRoot = mRoot;
+            mStart = mState.mCounters.read();
+        }
+
+        ~Resume() {
+            Sample end = mState.mCounters.read();
+            mState.mCurrentRoot = mPreviousRoot;
+            try {
+                auto [it, inserted] =
+                    mState.mUsage.try_emplace(mRoot, Usage{mRoot, 0, {}});
+                Usage &u = it->second;
+                ++u.mResumes;
+                for (std::size_t i = 0; i < kCounterCount; ++i) {
+                    // 读取失败时结束值为 0，不计入
+                    if (end[i] > mStart[i]) {
+                        u.mTotals[i] += end[i] - mStart[i];
+                    }
+                }
+            } catch (...) {
+            }
+        }
+#else
+        explicit Resume(void const *) noexcept {}
+#endif
+
+        Resume(Resume &&) = delete;
+    };
+
+    // 本线程上该项计数器是否可用
+    static bool available([[maybe_unused]] Counter counter) {
+#if CO_PERF
+        return local().mCounters.mAvailable[counter];
+#else
+        return false;
+#endif
+    }
+
+    // 按 CPU 时间从大到小排列，同名函数（可能来自不同翻译单元）合并
+    static std::vector<Usage> usage() {
+        std::vector<Usage> result;
+#if CO_PERF
+        std::unordered_map<std::string_view, std::size_t> index;
+        for (auto &[function, u]: local().mUsage) {
+            auto [it, inserted] = index.try_emplace(function, result.size());
+            if (inserted) {
+                result.push_back(u);
+                continue;
+            }
+            Usage &merged = result[it->second];
+            merged.mResumes += u.mResumes;
+            for (std::size_t i = 0; i < kCounterCount; ++i) {
+                merged.mTotals[i] += u.mTotals[i];
+            }
+        }
+        std::sort(result.begin(), result.end(),
+                  [](Usage const &lhs, Usage const &rhs) {
+                      return lhs.mTotals[kCpuNanos] > rhs.mTotals[kCpuNanos];
+                  });
+#endif
+        return result;
+    }
+
+    // 清空本线程的累计值
+    static void clear() {
+#if CO_PERF
+        local().mUsage.clear();
+#endif
+    }
+
+    // 输出 CPU 时间最多的前 top 个根任务函数，不可用的计数器显示为 -
+    static void writeTop(std::ostream &out, std::size_t top = 10) {
+        std::vector<Usage> all = usage();
+        out << std::setw(10) << "resumes" << std::setw(12) << "cpu(us)"
+            << std::setw(14) << "cycles" << std::setw(14) << "instructions"
+            << std::setw(14) << "cache-misses" << "  root task\n";
+        for (std::size_t i = 0; i < all.size() && i < top; ++i) {
+            Usage const &u = all[i];
+            out << std::setw(10) << u.mResumes << std::setw(12)
+                << u.mTotals[kCpuNanos] / 1000;
+            for (Counter c: {kCycles, kInstructions, kCacheMisses}) {
+                out << std::setw(14);
+                if (available(c)) {
+                    out << u.mTotals[c];
+                } else {
+                    out << '-';
+                }
+            }
+            out << "  " << u.mFunction << '\n';
+        }
+    }
+};
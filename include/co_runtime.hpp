@@ -0,0 +1,880 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <source_location>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <rbtree.hpp>
+#include <pairing_heap.hpp>
+#include <dary_heap.hpp>
+#include <co_trace.hpp>
+#include <co_latency.hpp>
+#include <co_frames.hpp>
+#include <co_perf.hpp>
+
+// 协程运行时：Task、调度器 Loop、定时器、when_all/when_any
+
+template <class T = void>
+struct NonVoidHelper {
+    using Type = T;
+};
+
+template <>
+struct NonVoidHelper<void> {
+    using Type = NonVoidHelper;
+
+    explicit NonVoidHelper() = default;
+    // 表示这个结构体有一个显式的默认构造函数
+    // explicit 关键字防止了构造函数的隐式转换
+    // 而 = default 表示使用编译器生成的默认构造函数。
+};
+
+// 封装未初始化的值模板
+template <class T>
+struct Uninitialized {
+    // 不会自动调用成员mValue的构造函数来初始化
+    // 因此其内存释放也需要额外管理
+    union {
+        T mValue;
+    };
+
+    Uninitialized() noexcept {}
+    Uninitialized(Uninitialized &&) = delete;
+    ~Uninitialized() noexcept {}
+
+    // 手动调用 T 类型对象的析构函数,Union需要显式析构
+    T moveValue() {
+        T ret(std::move(mValue));
+        mValue.~T();
+        return ret;
+    }
+
+    template <class... Ts> void putValue(Ts &&...args) {
+        // addressof()获取地址
+        new (std::addressof(mValue)) T(std::forward<Ts>(args)...);
+        //定位new表达式（placement new）
+        //它允许你在已经分配的内存上直接构造对象
+        //手动构造一个类型为 T 的对象
+        //并将其放置在 mResult 所指向的内存地址上
+        // forward<Ts>保证了参数 args 的完美转发
+        // 即保持了参数的原始值类别（左值或右值）。
+    }
+};
+
+template <>
+struct Uninitialized<void> {
+    auto moveValue() {
+        return NonVoidHelper<>{};
+    }
+
+    void putValue(NonVoidHelper<>) {}
+};
+//特化版本，它们处理常量类型、左值引用类型和右值引用类型的情况
+template <class T> struct Uninitialized<T const> : Uninitialized<T> {};
+
+template <class T>
+struct Uninitialized<T &> : Uninitialized<std::reference_wrapper<T>> {};
+
+template <class T> struct Uninitialized<T &&> : Uninitialized<T> {};
+
+// 自行定义了Awaiter与Awaitable 可以对其功能进行拓展
+// 需要对其进行拓展的原因是RetType和NonVoidRetType
+template <class A>
+concept Awaiter = requires(A a, std::coroutine_handle<> h) {
+    { a.await_ready() };
+    { a.await_suspend(h) };
+    { a.await_resume() };
+};
+
+template <class A>
+concept Awaitable = Awaiter<A> || requires(A a) {
+    { a.operator co_await() } -> Awaiter;
+};
+
+template <class A> struct AwaitableTraits;
+
+template <Awaiter A> struct AwaitableTraits<A> {
+    //在编译时推导出 A 类型的 await_resume 成员函数的返回类型，而不需要构造 A 类型的对象
+    using RetType = decltype(std::declval<A>().await_resume());
+    using NonVoidRetType = NonVoidHelper<RetType>::Type;
+};
+
+template <class A>
+    requires(!Awaiter<A> && Awaitable<A>)
+struct AwaitableTraits<A>
+    : AwaitableTraits<decltype(std::declval<A>().operator co_await())> {};
+
+// 协程句柄安全转换
+// 将coroutine_handle<P>的协程句柄转换为coroutine_handle<To>
+// 其中 P 必须是从 To 派生的类型
+template <class To, std::derived_from<To> P>
+constexpr std::coroutine_handle<To> staticHandleCast(std::coroutine_handle<P> coroutine) {
+    return std::coroutine_handle<To>::from_address(coroutine.address());
+}
+
+
+struct RepeatAwaiter // awaiter(原始指针) / awaitable(operator->)
+{
+    bool await_ready() const noexcept { return false; }
+    // 销毁操作，return true说明协程结果已经得到，不需要执行
+    // 结果一般都是false（肯定不销毁啦）
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> coroutine) const noexcept {
+        if (coroutine.done())
+            return std::noop_coroutine(); // 代表不需要挂起,会立即执行
+        else
+            return coroutine;
+    }
+    // 挂起操作，传入coroutine_handle类型的参数，在函数中调用handle.resume()，就可以恢复协程
+
+    void await_resume() const noexcept {}
+    // 恢复操作，返回值就是co_await的返回值
+};
+
+struct PreviousAwaiter {
+    std::coroutine_handle<> mPrevious;
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> coroutine) const noexcept {
+        CoTrace::leave();
+        // 等待mPrevious,不为空则移交控制权
+        if (mPrevious){
+            CoTrace::enter(mPrevious.address());
+            return mPrevious;
+        }else{
+            return std::noop_coroutine();
+        }
+    }
+
+    void await_resume() const noexcept {}
+};
+
+template <class T>
+struct Promise {
+    // 开始挂起
+    // 表达式恢复（无论是立即还是异步）时
+    // 协程开始执行你编写的协程体语句。
+    auto initial_suspend() noexcept {
+        return std::suspend_always();
+    }
+    // 结束挂起
+    auto final_suspend() noexcept {
+        return PreviousAwaiter(mPrevious);
+    }
+    // 句柄中错误
+    // 如果执行离开 body-statements 是由于未处理的异常，则：
+    //1. 捕获异常并在catch块内调用promise.unhandled_exception()
+    //2. 调用promise.final_suspend()并co_await结果。 
+    void unhandled_exception() noexcept {
+        mException = std::current_exception();
+    }
+
+    void return_value(T &&ret) {
+        mResult.putValue(std::move(ret));
+    }
+
+        // co_return value 的调用
+    void return_value(T const &ret) {
+        mResult.putValue(ret);
+    }
+
+    T ReturnResult() {
+        if(mException) [[unlikely]] {
+            std::rethrow_exception(mException);
+        }
+        return mResult.moveValue();
+    }
+    // 获取当协程首次挂起时返回给调用者的结果
+    // 将结果保存为局部变量
+    // 默认参数在协程函数处求值，loc 即协程函数的位置
+    std::coroutine_handle<Promise> get_return_object(
+        std::source_location const &loc = std::source_location::current()) {
+        auto coroutine = std::coroutine_handle<Promise>::from_promise(*this);
+        CoTrace::create(coroutine.address(), loc);
+#if CO_FRAMES
+        CoFrames::create(mFrameRecord, loc);
+#endif
+        CoPerf::create(coroutine.address(), loc);
+        return coroutine;
+    }
+    // 防止对象初始化,但需要通过mResult.~T()的方式手动释放内存
+
+    std::coroutine_handle<> mPrevious{};
+    std::exception_ptr mException{};
+    Uninitialized<T> mResult;
+
+#if CO_PERF
+    ~Promise() {
+        CoPerf::destroy(
+            std::coroutine_handle<Promise>::from_promise(*this).address());
+    }
+#endif
+
+#if CO_FRAMES
+    // 协程帧经 CoFrames 分配以记下大小，由 mFrameRecord 登记在存活帧表中
+    static void *operator new(std::size_t size) {
+        return CoFrames::allocate(size);
+    }
+
+    static void operator delete(void *frame, std::size_t size) noexcept {
+        CoFrames::deallocate(frame, size);
+    }
+
+    CoFrames::Record mFrameRecord;
+
+    // 每次 co_await 前记下挂起的时刻
+    template <class A>
+    A &&await_transform(A &&awaitable) noexcept {
+        CoFrames::suspend(mFrameRecord);
+        return std::forward<A>(awaitable);
+    }
+#endif
+
+    Promise &operator=(Promise &&) = delete;
+    // 删掉默认五个函数
+};
+
+// void类型不能被构造或赋值，需要模板特化
+template <>
+struct Promise<void> {
+    auto initial_suspend() noexcept {
+        return std::suspend_always();
+    }
+
+    auto final_suspend() noexcept {
+        return PreviousAwaiter(mPrevious);
+    }
+
+    void unhandled_exception() noexcept {
+        mException = std::current_exception();
+    }
+
+    void return_void() noexcept {}
+
+    void ReturnResult() {
+        if (mException) [[unlikely]] {
+            std::rethrow_exception(mException);
+        }
+    }
+
+    std::coroutine_handle<Promise> get_return_object(
+        std::source_location const &loc = std::source_location::current()) {
+        auto coroutine = std::coroutine_handle<Promise>::from_promise(*this);
+        CoTrace::create(coroutine.address(), loc);
+#if CO_FRAMES
+        CoFrames::create(mFrameRecord, loc);
+#endif
+        CoPerf::create(coroutine.address(), loc);
+#if CO_PERF
+        mFrame = coroutine.address();
+#endif
+        return coroutine;
+    }
+
+    std::coroutine_handle<> mPrevious{};
+    std::exception_ptr mException{};
+
+#if CO_PERF
+    // 作为 BasicSleepUntilPromise 的基类时不在帧首，析构时不能再用 from_promise 取帧地址，
+    // 由 get_return_object 记下
+    void const *mFrame = nullptr;
+
+    ~Promise() {
+        CoPerf::destroy(mFrame);
+    }
+#endif
+
+#if CO_FRAMES
+    // 协程帧经 CoFrames 分配以记下大小，由 mFrameRecord 登记在存活帧表中
+    static void *operator new(std::size_t size) {
+        return CoFrames::allocate(size);
+    }
+
+    static void operator delete(void *frame, std::size_t size) noexcept {
+        CoFrames::deallocate(frame, size);
+    }
+
+    CoFrames::Record mFrameRecord;
+
+    // 每次 co_await 前记下挂起的时刻
+    template <class A>
+    A &&await_transform(A &&awaitable) noexcept {
+        CoFrames::suspend(mFrameRecord);
+        return std::forward<A>(awaitable);
+    }
+#endif
+
+    Promise &operator=(Promise &&) = delete;
+    // 删掉了默认五个函数
+    //保持了类的平凡性（triviality）和标准布局（standard layout）
+    //平凡的类型通常可以安全地进行内存复制操作
+    //如memcpy，并且它们的对象在内存中的布局与C语言中的结构体兼容。
+    //类型如果是标准布局的，它的内存布局将与C语言中的结构体相同
+};
+
+template <class T = void, class P = Promise<T>>
+struct Task {
+    using promise_type = P;
+
+    Task(std::coroutine_handle<promise_type> coroutine) noexcept
+        : mCoroutine(coroutine) {}
+    // 删除移动构造函数，防止非预期复制
+    Task(Task &&) = delete;
+    // 析构时，保证协程资源释放
+    ~Task() {
+        mCoroutine.destroy();
+    }
+
+    struct Awaiter {
+        bool await_ready() const noexcept { return false; }
+        // 类型安全的，因为只接受promise_type类型的Promise对象
+        std::coroutine_handle<promise_type> await_suspend(std::coroutine_handle<> coroutine) const noexcept {
+            mCoroutine.promise().mPrevious = coroutine;
+            CoTrace::enter(mCoroutine.address(), coroutine.address());
+            return mCoroutine;
+        }
+
+        T await_resume() const {
+            CoTrace::enter(mCoroutine.promise().mPrevious.address());
+            return mCoroutine.promise().ReturnResult();
+        }
+
+        std::coroutine_handle<promise_type> mCoroutine;
+    };
+
+    Awaiter operator co_await() const noexcept {
+        return Awaiter(mCoroutine);
+    }
+    // 允许 Task 对象被隐式转换为 std::coroutine_handle<>
+    operator std::coroutine_handle<>() const noexcept {
+        return mCoroutine;
+    }
+
+    std::coroutine_handle<promise_type> mCoroutine;
+};
+
+// 定时器容器，结点不保存容器指针以缩小协程帧
+// RbTree、PairingHeap、DaryHeap 接口一致，可任选其一作为 BasicLoop 的参数
+template <class T>
+using RbTimerQueue = RbTree<T, std::less<T>, false>;
+
+template <class T>
+using PairingTimerQueue = PairingHeap<T>;
+
+template <class T>
+using DaryTimerQueue = DaryHeap<T>;
+
+// 调度器实际使用的定时器容器，RbTree 保证同一时间点的定时器按加入顺序唤醒
+template <class T>
+using DefaultTimerQueue = RbTimerQueue<T>;
+
+template <template <class> class TimerQueue>
+struct BasicLoop;
+
+template <template <class> class TimerQueue = DefaultTimerQueue>
+BasicLoop<TimerQueue> &getLoop();
+
+// 继承自定时器容器的结点，可以按照时间排列，唤醒协程
+template <template <class> class TimerQueue>
+struct BasicSleepUntilPromise
+    : TimerQueue<BasicSleepUntilPromise<TimerQueue>>::Node, Promise<void> {
+    std::chrono::system_clock::time_point mExpireTime;
+
+    BasicSleepUntilPromise() = default;
+
+    // 未到期就被销毁时（例如 when_any 中落败的任务仍在睡眠）从容器中摘除
+    ~BasicSleepUntilPromise() {
+        if (this->is_linked()) {
+            getLoop<TimerQueue>().mTimers.erase(*this);
+        }
+    }
+
+    auto get_return_object(
+        std::source_location const &loc = std::source_location::current()) {
+        auto coroutine =
+            std::coroutine_handle<BasicSleepUntilPromise>::from_promise(*this);
+        CoTrace::create(coroutine.address(), loc);
+#if CO_FRAMES
+        CoFrames::create(this->mFrameRecord, loc);
+#endif
+        CoPerf::create(coroutine.address(), loc);
+#if CO_PERF
+        this->mFrame = coroutine.address();
+#endif
+        return coroutine;
+    }
+
+    BasicSleepUntilPromise &operator=(BasicSleepUntilPromise &&) = delete;
+
+    friend bool operator<(BasicSleepUntilPromise const &lhs, BasicSleepUntilPromise const &rhs) noexcept {
+        return lhs.mExpireTime < rhs.mExpireTime;
+    }
+};
+
+// 调度器
+template <template <class> class TimerQueue>
+struct BasicLoop {
+    using SleepUntilPromise = BasicSleepUntilPromise<TimerQueue>;
+
+    // 定时器容器，时间早的默认在前
+    TimerQueue<SleepUntilPromise> mTimers{};
+    struct ReadyEntry {
+        std::coroutine_handle<> mCoroutine;
+#if CO_LATENCY
+        // 进入就绪队列时所在那一轮调度的 LatencyClock 时间戳
+        std::uint64_t mReadyTick;
+#endif
+    };
+
+    // 就绪队列：可以立即运行、等待调度器恢复的协程，先进先出
+    std::deque<ReadyEntry> mReadyQueue{};
+
+    // 定时器实际唤醒比 mExpireTime 晚了多久
+    LatencyHistogram mTimerLateness{};
+    // 协程从进入就绪队列到被恢复等了多久
+    LatencyHistogram mReadyWait{};
+    // 非零时 run() 每隔这么久把延迟摘要写到 std::cerr 并清零直方图
+    std::chrono::steady_clock::duration mLatencyDumpInterval{};
+    std::chrono::steady_clock::time_point mNextLatencyDump{};
+#if CO_LATENCY
+    // 随 Loop 一起构造，校准的忙等发生在此处而不是第一次出队时
+    LatencyClock mLatencyClock{};
+    // 本轮调度（一批 runReady 或一次定时器唤醒）开始时读一次时钟，
+    // 期间入队的协程都记为此刻入队，出队时按其所在一轮开始的时刻计算等待，
+    // 误差不超过一轮的长度
+    std::uint64_t mDispatchTick = LatencyClock::now();
+#endif
+
+    // 增加结点
+    void addTimer(SleepUntilPromise &promise) {
+        mTimers.insert(promise);
+    }
+
+    void addReady(std::coroutine_handle<> coroutine) {
+#if CO_LATENCY
+        mReadyQueue.push_back({coroutine, mDispatchTick});
+#else
+        mReadyQueue.push_back({coroutine});
+#endif
+    }
+
+    // 恢复此刻已在就绪队列中的协程，期间新加入的留到下一轮，返回恢复的个数
+    std::size_t runReady() {
+        std::size_t n = mReadyQueue.size();
+#if CO_LATENCY
+        if (n != 0) {
+            mDispatchTick = LatencyClock::now();
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i) {
+            ReadyEntry entry = mReadyQueue.front();
+            mReadyQueue.pop_front();
+            auto coroutine = entry.mCoroutine;
+#if CO_LATENCY
+            mReadyWait.record(
+                mLatencyClock.nanosBetween(entry.mReadyTick, mDispatchTick));
+#endif
+            CoTrace::enter(coroutine.address());
+            {
+                CoPerf::Resume perf(coroutine.address());
+                coroutine.resume();
+            }
+            CoTrace::leave();
+        }
+        return n;
+    }
+
+    // 两行摘要：定时器迟到与就绪等待的 p50/p99/p999/max
+    void writeLatency(std::ostream &out) const {
+        mTimerLateness.writeText(out, "timer lateness");
+        mReadyWait.writeText(out, "ready wait");
+    }
+
+    void resetLatency() noexcept {
+        mTimerLateness.reset();
+        mReadyWait.reset();
+    }
+
+    // 设置了 mLatencyDumpInterval 时，到点输出并清零
+    void dumpLatencyIfDue() {
+        if (mLatencyDumpInterval == std::chrono::steady_clock::duration{}) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now < mNextLatencyDump) {
+            return;
+        }
+        // 第一次只确定起点
+        if (mNextLatencyDump != std::chrono::steady_clock::time_point{}) {
+            writeLatency(std::cerr);
+            resetLatency();
+        }
+        mNextLatencyDump = now + mLatencyDumpInterval;
+    }
+
+    void run(std::coroutine_handle<> coroutine) {
+        while (!coroutine.done()) {
+            // 协程未执行完时，恢复协程继续执行
+#if CO_LATENCY
+            mDispatchTick = LatencyClock::now();
+#endif
+            CoTrace::enter(coroutine.address());
+            {
+                CoPerf::Resume perf(coroutine.address());
+                coroutine.resume();
+            }
+            CoTrace::leave();
+            while (!mReadyQueue.empty() || !mTimers.empty()) {
+                dumpLatencyIfDue();
+                runReady();
+                // 容器不为空时
+                if (!mTimers.empty()) {
+                    auto nowTime = std::chrono::system_clock::now();
+                    // 获取最早的时间点
+                    auto &promise = mTimers.front();
+                    // 早于当前时间则删除结点，否则睡眠到该时间点
+                    if (promise.mExpireTime < nowTime) {
+                        mTimers.pop_front();
+                        auto sleeper = std::coroutine_handle<SleepUntilPromise>::from_promise(promise);
+                        CoTrace::timer(sleeper.address(), nowTime - promise.mExpireTime);
+#if CO_LATENCY
+                        mTimerLateness.record(nowTime - promise.mExpireTime);
+                        mDispatchTick = LatencyClock::now();
+#endif
+                        CoTrace::enter(sleeper.address());
+                        {
+                            CoPerf::Resume perf(sleeper.address());
+                            sleeper.resume();
+                        }
+                        CoTrace::leave();
+                    } else if (mReadyQueue.empty()) {
+                        std::this_thread::sleep_until(promise.mExpireTime);
+                    }
+                }
+            }
+        }
+    }
+
+    BasicLoop &operator=(BasicLoop &&) = delete;
+};
+
+template <template <class> class TimerQueue>
+BasicLoop<TimerQueue> &getLoop() {
+    // 静态全局返回，单例模式
+    // 多线程安全，不会构造两次
+    static BasicLoop<TimerQueue> loop;
+    return loop;
+}
+
+using Loop = BasicLoop<DefaultTimerQueue>;
+using SleepUntilPromise = Loop::SleepUntilPromise;
+
+// 以下等待体与函数都以定时器容器为模板参数，默认使用 DefaultTimerQueue；
+// 用其它容器的 BasicLoop 时须显式指定同一个容器，例如 sleep_for<PairingTimerQueue>(1s)，
+// 否则定时器会加到另一个（不会运行的）Loop 上
+template <template <class> class TimerQueue>
+struct BasicSleepAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<BasicSleepUntilPromise<TimerQueue>> coroutine) const {
+        auto &promise = coroutine.promise();
+        promise.mExpireTime = mExpireTime;
+        loop.addTimer(promise);
+    }
+
+    void await_resume() const noexcept {}
+
+    BasicLoop<TimerQueue> &loop;
+    std::chrono::system_clock::time_point mExpireTime;
+};
+
+using SleepAwaiter = BasicSleepAwaiter<DefaultTimerQueue>;
+
+// co_await reschedule() 把当前协程放到就绪队列末尾，让其它就绪的协程先运行
+template <template <class> class TimerQueue>
+struct BasicRescheduleAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coroutine) const {
+        loop.addReady(coroutine);
+    }
+
+    void await_resume() const noexcept {}
+
+    BasicLoop<TimerQueue> &loop;
+};
+
+using RescheduleAwaiter = BasicRescheduleAwaiter<DefaultTimerQueue>;
+
+template <template <class> class TimerQueue = DefaultTimerQueue>
+BasicRescheduleAwaiter<TimerQueue> reschedule() {
+    return BasicRescheduleAwaiter<TimerQueue>(getLoop<TimerQueue>());
+}
+
+// 睡眠到什么时间点
+template <template <class> class TimerQueue = DefaultTimerQueue>
+Task<void, BasicSleepUntilPromise<TimerQueue>> sleep_until(std::chrono::system_clock::time_point expireTime) {
+    auto &loop = getLoop<TimerQueue>();
+    co_await BasicSleepAwaiter<TimerQueue>(loop, expireTime);
+}
+
+// 睡眠一段时间
+template <template <class> class TimerQueue = DefaultTimerQueue>
+Task<void, BasicSleepUntilPromise<TimerQueue>> sleep_for(std::chrono::system_clock::duration duration) {
+    // 时间点加时间段等于时间点
+    auto &loop = getLoop<TimerQueue>();
+    co_await BasicSleepAwaiter<TimerQueue>(loop, std::chrono::system_clock::now() + duration);
+    co_return;
+}
+
+struct ReturnPreviousPromise {
+    auto initial_suspend() noexcept {
+        return std::suspend_always();
+    }
+
+    auto final_suspend() noexcept {
+        return PreviousAwaiter(mPrevious);
+    }
+
+    void unhandled_exception() {
+        throw;
+    }
+
+    void return_value(std::coroutine_handle<> previous) noexcept {
+        mPrevious = previous;
+    }
+
+    auto get_return_object(
+        std::source_location const &loc = std::source_location::current()) {
+        auto coroutine =
+            std::coroutine_handle<ReturnPreviousPromise>::from_promise(*this);
+        CoTrace::create(coroutine.address(), loc);
+#if CO_FRAMES
+        CoFrames::create(mFrameRecord, loc);
+#endif
+        CoPerf::create(coroutine.address(), loc);
+        return coroutine;
+    }
+
+    std::coroutine_handle<> mPrevious{};
+
+#if CO_PERF
+    ~ReturnPreviousPromise() {
+        CoPerf::destroy(
+            std::coroutine_handle<ReturnPreviousPromise>::from_promise(*this)
+                .address());
+    }
+#endif
+
+#if CO_FRAMES
+    // 协程帧经 CoFrames 分配以记下大小，由 mFrameRecord 登记在存活帧表中
+    static void *operator new(std::size_t size) {
+        return CoFrames::allocate(size);
+    }
+
+    static void operator delete(void *frame, std::size_t size) noexcept {
+        CoFrames::deallocate(frame, size);
+    }
+
+    CoFrames::Record mFrameRecord;
+
+    // 每次 co_await 前记下挂起的时刻
+    template <class A>
+    A &&await_transform(A &&awaitable) noexcept {
+        CoFrames::suspend(mFrameRecord);
+        return std::forward<A>(awaitable);
+    }
+#endif
+
+    ReturnPreviousPromise &operator=(ReturnPreviousPromise &&) = delete;
+};
+
+struct ReturnPreviousTask {
+    // 为什么不直接用Promise<std::coroutine_handle<>>?
+    // 为什么不直接用Task<std::coroutine_handle<>>?
+    using promise_type = ReturnPreviousPromise;
+
+    ReturnPreviousTask(std::coroutine_handle<promise_type> coroutine) noexcept
+        : mCoroutine(coroutine) {}
+
+    ReturnPreviousTask(ReturnPreviousTask &&) = delete;
+
+    ~ReturnPreviousTask() {
+        mCoroutine.destroy();
+    }
+
+    std::coroutine_handle<promise_type> mCoroutine;
+};
+
+struct WhenAllCtlBlock {
+    std::size_t mCount;
+    std::coroutine_handle<> mPrevious{};
+    std::exception_ptr mException{};
+};
+
+struct WhenAllAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<> coroutine) const {
+        if (mTasks.empty()) return coroutine;
+        mControl.mPrevious = coroutine;
+        for (auto const &t: mTasks.subspan(0, mTasks.size() - 1)) {
+            CoTrace::enter(t.mCoroutine.address(), coroutine.address());
+            t.mCoroutine.resume();
+            CoTrace::enter(coroutine.address());
+        }
+        CoTrace::enter(mTasks.back().mCoroutine.address(), coroutine.address());
+        return mTasks.back().mCoroutine;
+    }
+
+    void await_resume() const {
+        if (mControl.mException) [[unlikely]] {
+            std::rethrow_exception(mControl.mException);
+        }
+    }
+
+    WhenAllCtlBlock &mControl;
+    std::span<ReturnPreviousTask const> mTasks;
+};
+
+template <class T>
+ReturnPreviousTask whenAllHelper(auto const &t, WhenAllCtlBlock &control,
+                                 Uninitialized<T> &result) {
+    try {
+        // 等待任务 t 完成，并将结果存储在 result 中
+        result.putValue(co_await t);
+    } catch (...) {
+        // 如果任务 t 抛出异常，捕获异常并存储在控制块中
+        control.mException = std::current_exception();
+        // 提前返回之前挂起的协程句柄
+        co_return control.mPrevious;
+    }
+    --control.mCount;
+    // 如果所有任务都已完成（计数为0），返回之前挂起的协程句柄
+    if (control.mCount == 0) {
+        co_return control.mPrevious;
+    }
+    // 还有任务没完成，返回nullptr
+    co_return nullptr;
+}
+
+template <std::size_t... Is, class... Ts>
+Task<std::tuple<typename AwaitableTraits<Ts>::NonVoidRetType...>>
+whenAllImpl(std::index_sequence<Is...>, Ts &&...ts) {
+    // 创建控制块对象
+    WhenAllCtlBlock control{sizeof...(Ts)};
+    // 用于存储每个异步操作的结果，同时留着空间未初始化
+    std::tuple<Uninitialized<typename AwaitableTraits<Ts>::RetType>...> result;
+    // 创建了一个任务数组
+    ReturnPreviousTask taskArray[]{whenAllHelper(ts, control, std::get<Is>(result))...};
+    // 挂起等待
+    co_await WhenAllAwaiter(control, taskArray);
+    // 返回结果
+    co_return std::tuple<typename AwaitableTraits<Ts>::NonVoidRetType...>(
+        std::get<Is>(result).moveValue()...);
+}
+
+
+// 编译时检查，确保传入的异步操作数量不为零
+template <Awaitable... Ts>
+    requires(sizeof...(Ts) != 0)
+auto when_all(Ts &&...ts) {
+    // （编译时生成的索引序列, 任务）
+    return whenAllImpl(std::make_index_sequence<sizeof...(Ts)>{},
+                       std::forward<Ts>(ts)...);
+}
+
+struct WhenAnyCtlBlock {
+    static constexpr std::size_t kNullIndex = std::size_t(-1);
+    // 初始化为最大值，表示开始时没有任何协程完成
+    std::size_t mIndex{kNullIndex};
+    std::coroutine_handle<> mPrevious{};
+    std::exception_ptr mException{};
+};
+
+struct WhenAnyAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<> coroutine) const {
+        if (mTasks.empty()) return coroutine;
+        mControl.mPrevious = coroutine;
+        for (auto const &t: mTasks.subspan(0, mTasks.size() - 1)) {
+            CoTrace::enter(t.mCoroutine.address(), coroutine.address());
+            t.mCoroutine.resume();
+            CoTrace::enter(coroutine.address());
+        }
+        CoTrace::enter(mTasks.back().mCoroutine.address(), coroutine.address());
+        return mTasks.back().mCoroutine;
+    }
+
+    void await_resume() const {
+        // 在恢复前抛出异常
+        if (mControl.mException) [[unlikely]] {
+            std::rethrow_exception(mControl.mException);
+        }
+    }
+
+    WhenAnyCtlBlock &mControl;
+    std::span<ReturnPreviousTask const> mTasks;
+};
+
+template <class T>
+ReturnPreviousTask whenAnyHelper(auto const &t, WhenAnyCtlBlock &control,
+                                 Uninitialized<T> &result, std::size_t index) {
+    try {
+        result.putValue(co_await t);
+    } catch (...) {
+        control.mException = std::current_exception();
+        co_return control.mPrevious;
+    }
+    --control.mIndex = index;
+    // 有任务完成就返回
+    co_return control.mPrevious;
+}
+
+template <std::size_t... Is, class... Ts>
+// variant 只有其中一个为true，其中不能有void
+Task<std::variant<typename AwaitableTraits<Ts>::NonVoidRetType...>>
+whenAnyImpl(std::index_sequence<Is...>, Ts &&...ts) {
+    WhenAnyCtlBlock control{};
+    std::tuple<Uninitialized<typename AwaitableTraits<Ts>::RetType>...> result;
+    ReturnPreviousTask taskArray[]{whenAnyHelper(ts, control, std::get<Is>(result), Is)...};
+    co_await WhenAnyAwaiter(control, taskArray);
+    Uninitialized<std::variant<typename AwaitableTraits<Ts>::NonVoidRetType...>> varResult;
+    // 折叠表达式，执行左边语句，然后执行右边语句，最后返回右边表达式的结果
+    // 遍历所有可能的索引 Is，并检查 control.mIndex 是否等于每个索引。
+    // 如果是，它将使用 std::in_place_index<Is> 来构造 varResult 中的正确类型，并将对应的结果移动到变体中
+    // 返回值为0
+    ((control.mIndex == Is && (varResult.putValue(
+        std::in_place_index<Is>, std::get<Is>(result).moveValue()), 0)), ...);
+    // moveValue是对Uninitialized类中union成员的析构
+    co_return varResult.moveValue();
+}
+
+template <Awaitable... Ts>
+    requires(sizeof...(Ts) != 0)
+auto when_any(Ts &&...ts) {
+    return whenAnyImpl(std::make_index_sequence<sizeof...(Ts)>{},
+                       std::forward<Ts>(ts)...);
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 协程追踪（CO_TRACE 时启用，否则各记录函数为空操作）
+// 在协程创建、Task 的 await_suspend/await_resume、final_suspend、
+// Loop 的恢复点与定时器到期处记录事件，写入各线程自己的缓冲
+// 导出为 Chrome trace-event JSON，可在 Perfetto 或 chrome://tracing 中打开：
+// 协程每段连续执行是所在线程上的一个切片，每条 mPrevious 链接（谁在等待谁）
+// 是一条从等待者指向被等待者的 flow 箭头
+// 导出时各线程应已停止记录
+struct CoTrace {
+private:
+    enum Kind : std::uint8_t {
+        kCreate,
+        kEnter,
+        kLeave,
+        kTimer,
+    };
+
+    struct Event {
+        // steady_clock 纳秒
+        std::uint64_t mTime;
+        void const *mFrame;
+        // kCreate：函数名；kEnter：等待者的帧（没有则为 0）；kTimer：迟到的纳秒数
+        std::uintptr_t mData;
+        Kind mKind;
+    };
+
+    struct Buffer {
+        std::vector<Event> mEvents;
+        std::uint32_t mTid;
+    };
+
+    struct State {
+        std::mutex mMutex;
+        // 线程退出后缓冲仍保留，直到 clear()
+        std::vector<std::unique_ptr<Buffer>> mBuffers;
+    };
+
+    static State &global() {
+        static State state;
+        return state;
+    }
+
+    static Buffer &local() {
+        static thread_local Buffer *buffer = [] {
+            State &g = global();
+            std::lock_guard lock(g.mMutex);
+            auto &b = g.mBuffers.emplace_back(std::make_unique<Buffer>());
+            b->mTid = static_cast<std::uint32_t>(g.mBuffers.size());
+            b->mEvents.reserve(4096);
+            return b.get();
+        }();
+        return *buffer;
+    }
+
+    [[maybe_unused]] static void record(Kind kind, void const *frame,
+                                        std::uintptr_t data) noexcept {
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+        try {
+            local().mEvents.push_back(
+                {static_cast<std::uint64_t>(time), frame, data, kind});
+        } catch (...) {
+        }
+    }
+
+    // 纳秒写成带三位小数的微秒
+    static void writeMicros(std::ostream &out, std::uint64_t ns) {
+        char frac[4] = {char('0' + ns / 100 % 10), char('0' + ns / 10 % 10),
+                        char('0' + ns % 10), 0};
+        out << ns / 1000 << '.' << frac;
+    }
+
+    static void writeString(std::ostream &out, std::string_view s) {
+        out << '"';
+        for (char c: s) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (c >= 0 && c < 0x20) {
+                out << ' ';
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+public:
+    // 协程帧创建，loc 为协程函数的位置（在 get_return_object 的默认参数中取得）
+    static void create([[maybe_unused]] void const *frame,
+                       [[maybe_unused]] std::source_location const &loc) noexcept {
+#if CO_TRACE
+        record(kCreate, frame,
+               reinterpret_cast<std::uintptr_t>(loc.function_name()));
+#endif
+    }
+
+    // 当前线程开始（或继续）执行 frame；previous 非空表示 previous 等待 frame
+    static void enter([[maybe_unused]] void const *frame,
+                      [[maybe_unused]] void const *previous = nullptr) noexcept {
+#if CO_TRACE
+        record(kEnter, frame, reinterpret_cast<std::uintptr_t>(previous));
+#endif
+    }
+
+    // 当前线程离开协程代码（协程结束且无人等待，或回到调度器）
+    static void leave() noexcept {
+#if CO_TRACE
+        record(kLeave, nullptr, 0);
+#endif
+    }
+
+    // 定时器到期，lateness 为实际唤醒时间晚于到期时间的长度
+    static void timer([[maybe_unused]] void const *frame,
+                      [[maybe_unused]] std::chrono::nanoseconds lateness) noexcept {
+#if CO_TRACE
+        record(kTimer, frame,
+               static_cast<std::uintptr_t>(std::max<std::int64_t>(
+                   lateness.count(), 0)));
+#endif
+    }
+
+    // 丢弃已记录的事件
+    static void clear() {
+        State &g = global();
+        std::lock_guard lock(g.mMutex);
+        for (auto &b: g.mBuffers) {
+            b->mEvents.clear();
+        }
+    }
+
+    static void writeJson(std::ostream &out) {
+        State &g = global();
+        std::lock_guard lock(g.mMutex);
+        std::vector<std::pair<std::uint32_t, Event const *>> events;
+        for (auto &b: g.mBuffers) {
+            for (Event const &e: b->mEvents) {
+                events.emplace_back(b->mTid, &e);
+            }
+        }
+        std::stable_sort(events.begin(), events.end(),
+                         [](auto const &lhs, auto const &rhs) {
+                             return lhs.second->mTime < rhs.second->mTime;
+                         });
+        std::uint64_t base = events.empty() ? 0 : events.front().second->mTime;
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        auto begin = [&](char const *ph, std::uint32_t tid, std::uint64_t time) {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"" << ph
+                << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+            writeMicros(out, time - base);
+            first = false;
+        };
+        for (auto &b: g.mBuffers) {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << b->mTid
+                << ",\"name\":\"thread_name\",\"args\":{\"name\":\"thread "
+                << b->mTid << "\"}}";
+            first = false;
+        }
+
+        // 帧地址会被复用，名字按时间顺序随 kCreate 更新
+        std::unordered_map<void const *, char const *> names;
+        struct Running {
+            void const *mFrame = nullptr;
+            std::uint64_t mStart = 0;
+        };
+        std::unordered_map<std::uint32_t, Running> running;
+        std::uint64_t flowId = 0;
+        auto close = [&](std::uint32_t tid, Running &r, std::uint64_t time) {
+            if (r.mFrame == nullptr) {
+                return;
+            }
+            auto it = names.find(r.mFrame);
+            begin("X", tid, r.mStart);
+            out << ",\"dur\":";
+            writeMicros(out, time - r.mStart);
+            out << ",\"cat\":\"coroutine\",\"name\":";
+            writeString(out, it != names.end() ? it->second : "coroutine");
+            out << ",\"args\":{\"frame\":\"" << r.mFrame << "\"}}";
+            r.mFrame = nullptr;
+        };
+
+        for (auto [tid, e]: events) {
+            Running &r = running[tid];
+            switch (e->mKind) {
+            case kCreate:
+                names[e->mFrame] = reinterpret_cast<char const *>(e->mData);
+                break;
+            case kEnter:
+                if (r.mFrame == e->mFrame) {
+                    break;
+                }
+                close(tid, r, e->mTime);
+                if (e->mData != 0) {
+                    // 箭头起点须落在等待者的切片内，取切换时刻前 1 纳秒
+                    ++flowId;
+                    begin("s", tid,
+                          e->mTime > base ? e->mTime - 1 : e->mTime);
+                    out << ",\"id\":" << flowId
+                        << ",\"cat\":\"await\",\"name\":\"await\"}";
+                    begin("f", tid, e->mTime);
+                    out << ",\"id\":" << flowId
+                        << ",\"bp\":\"e\",\"cat\":\"await\",\"name\":\"await\"}";
+                }
+                r.mFrame = e->mFrame;
+                r.mStart = e->mTime;
+                break;
+            case kLeave:
+                close(tid, r, e->mTime);
+                break;
+            case kTimer:
+                begin("i", tid, e->mTime);
+                out << ",\"s\":\"t\",\"cat\":\"timer\",\"name\":\"timer "
+                       "expired\",\"args\":{\"frame\":\""
+                    << e->mFrame << "\",\"lateness_us\":";
+                writeMicros(out, e->mData);
+                out << "}}";
+                break;
+            }
+        }
+        std::uint64_t last = events.empty() ? 0 : events.back().second->mTime;
+        for (auto &[tid, r]: running) {
+            close(tid, r, last);
+        }
+        out << "\n]}\n";
+    }
+
+    // 写到文件，返回是否成功
+    static bool save(char const *path) {
+        std::ofstream out(path);
+        writeJson(out);
+        return static_cast<bool>(out);
+    }
+};
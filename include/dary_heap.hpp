@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// 侵入式 d 叉堆（默认 4 叉），接口与 RbTree 一致：insert、erase、front、
+// pop_front、empty
+// 结点只保存自己在数组中的下标，insert、pop_front、erase 均为 O(log n)
+// 堆数组按需扩容，可用 reserve 预留；结点析构前须先 erase
+// 与 RbTree 不同，键相等的元素取出顺序不确定
+template <class Value, class Compare = std::less<Value>, std::size_t Arity = 4>
+struct DaryHeap {
+    static_assert(Arity >= 2);
+
+    struct DaryNode {
+        DaryNode() noexcept : index(kNullIndex) {}
+
+        DaryNode(DaryNode &&) = delete;
+
+        bool is_linked() const noexcept {
+            return index != kNullIndex;
+        }
+
+        friend struct DaryHeap;
+
+    private:
+        static constexpr std::size_t kNullIndex = std::size_t(-1);
+
+        std::size_t index;
+    };
+
+    using Node = DaryNode;
+
+private:
+    std::vector<DaryNode *> heap;
+    Compare comp;
+
+    bool compare(DaryNode *left, DaryNode *right) const noexcept {
+        return comp(static_cast<Value &>(*left), static_cast<Value &>(*right));
+    }
+
+    void place(DaryNode *node, std::size_t index) noexcept {
+        heap[index] = node;
+        node->index = index;
+    }
+
+    // 空位上浮，避免逐层交换
+    void siftUp(DaryNode *node, std::size_t index) noexcept {
+        while (index > 0) {
+            std::size_t parent = (index - 1) / Arity;
+            if (!compare(node, heap[parent])) {
+                break;
+            }
+            place(heap[parent], index);
+            index = parent;
+        }
+        place(node, index);
+    }
+
+    void siftDown(DaryNode *node, std::size_t index) noexcept {
+        std::size_t size = heap.size();
+        while (true) {
+            std::size_t first = index * Arity + 1;
+            if (first >= size) {
+                break;
+            }
+            std::size_t last = first + Arity < size ? first + Arity : size;
+            std::size_t best = first;
+            for (std::size_t i = first + 1; i < last; ++i) {
+                if (compare(heap[i], heap[best])) {
+                    best = i;
+                }
+            }
+            if (!compare(heap[best], node)) {
+                break;
+            }
+            place(heap[best], index);
+            index = best;
+        }
+        place(node, index);
+    }
+
+    void doInsert(DaryNode *node) {
+        heap.push_back(node);
+        siftUp(node, heap.size() - 1);
+    }
+
+    // 用末尾结点填补空位，再视情况上浮或下沉
+    void doErase(DaryNode *node) noexcept {
+        std::size_t index = node->index;
+        node->index = DaryNode::kNullIndex;
+        DaryNode *last = heap.back();
+        heap.pop_back();
+        if (last == node) {
+            return;
+        }
+        if (index > 0 && compare(last, heap[(index - 1) / Arity])) {
+            siftUp(last, index);
+        } else {
+            siftDown(last, index);
+        }
+    }
+
+public:
+    DaryHeap() = default;
+
+    explicit DaryHeap(Compare comp) noexcept(noexcept(Compare(comp)))
+        : comp(comp) {}
+
+    DaryHeap(DaryHeap &&) = delete;
+
+    ~DaryHeap() noexcept {}
+
+    void reserve(std::size_t capacity) {
+        heap.reserve(capacity);
+    }
+
+    void insert(Value &value) {
+        doInsert(&static_cast<DaryNode &>(value));
+    }
+
+    void erase(Value &value) noexcept {
+        doErase(&static_cast<DaryNode &>(value));
+    }
+
+    bool empty() const noexcept {
+        return heap.empty();
+    }
+
+    std::size_t size() const noexcept {
+        return heap.size();
+    }
+
+    Value &front() const noexcept {
+        return static_cast<Value &>(*heap.front());
+    }
+
+    // 取出并删除最小结点，堆不能为空
+    Value &pop_front() noexcept {
+        DaryNode *node = heap.front();
+        doErase(node);
+        return static_cast<Value &>(*node);
+    }
+};
@@ -1,67 +1,131 @@
 #pragma once
 
-#ifndef NDEBUG
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#if DEBUG_SHOW_SOURCE
+#include <debug_source.hpp>
+#endif
+#include <source_location>
+#include <type_traits>
+#include <typeinfo>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__unix__) && __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+#if DEBUG_BINARY && !defined(DEBUG_ASYNC)
+#define DEBUG_ASYNC 1
+#endif
+#if DEBUG_ASYNC
+#include <debug_async.hpp>
+#endif
+#if DEBUG_BINARY
+#include <tuple>
+#include <utility>
+#endif
+
+// 日志级别，debug() 为 debug 级
+enum class debug_level : int {
+    trace,
+    debug,
+    info,
+    warn,
+    error,
+    off,
+};
 
+// 编译期最低级别（debug_level 的数值），低于它的语句编译为空操作：
+// 定义了 NDEBUG 时默认只保留 warn 与 error，否则全部保留
+#ifndef DEBUG_MIN_LEVEL
+#ifdef NDEBUG
+#define DEBUG_MIN_LEVEL 3
+#else
+#define DEBUG_MIN_LEVEL 0
+#endif
+#endif
 
-struct debug {
-    debug(bool = true, char const * = nullptr) noexcept {}
+// 低于编译期最低级别时使用的空实现
+struct debug_null {
+    debug_null(bool = true, char const * = nullptr) noexcept {}
 
-    debug(debug &&) = delete;
-    debug(debug const &) = delete;
+    debug_null(debug_null &&) = delete;
+    debug_null(debug_null const &) = delete;
 
     template <class T>
-    debug &operator,(T &&) {
+    debug_null &operator,(T &&) {
         return *this;
     }
 
     template <class T>
-    debug &operator<<(T &&) {
+    debug_null &operator<<(T &&) {
         return *this;
     }
 
-    debug &on(bool) {
+    debug_null &on(bool) {
         return *this;
     }
 
-    debug &fail(bool = true) {
+    debug_null &rate_limit(unsigned) {
         return *this;
     }
 
-    ~debug() noexcept(false) {}
+    debug_null &sample(unsigned) {
+        return *this;
+    }
+
+    debug_null &fail(bool = true) {
+        return *this;
+    }
+
+    ~debug_null() noexcept(false) {}
 
 private:
     struct debug_condition {
-        debug &d;
+        debug_null &d;
 
-        explicit debug_condition(debug &d) : d(d) {}
+        explicit debug_condition(debug_null &d) : d(d) {}
 
         template <class U>
-        debug &operator<(U const &) {
+        debug_null &operator<(U const &) {
             return d;
         }
 
         template <class U>
-        debug &operator>(U const &) {
+        debug_null &operator>(U const &) {
             return d;
         }
 
         template <class U>
-        debug &operator<=(U const &) {
+        debug_null &operator<=(U const &) {
             return d;
         }
 
         template <class U>
-        debug &operator>=(U const &) {
+        debug_null &operator>=(U const &) {
             return d;
         }
 
         template <class U>
-        debug &operator==(U const &) {
+        debug_null &operator==(U const &) {
             return d;
         }
 
         template <class U>
-        debug &operator!=(U const &) {
+        debug_null &operator!=(U const &) {
             return d;
         }
     };
@@ -77,28 +141,73 @@ public:
         return debug_condition{*this};
     }
 };
-#else
 
+struct debug_logger {
+private:
+#if DEBUG_BINARY
+    // 二进制模式（DEBUG_BINARY，隐含 DEBUG_ASYNC）：调用方只记录源码位置与
+    // 各参数的原始字节，格式化推迟到 debug_async 的后台线程，输出与文本模式逐字节相同
+    // 记录布局：source_location、line 指针，随后是若干条目，每条以一字节标记开头
+    // line 须指向静态存储的字符串
+    enum : unsigned char {
+        bin_marks,
+        bin_space,
+        bin_raw,
+        bin_quoted,
+        bin_scalar,
+    };
 
-#include <cstdint>
-#include <iomanip>
-#include <iostream>
-#if DEBUG_SHOW_SOURCE
-#include <fstream>
-#include <unordered_map>
-#endif
-#include <source_location>
-#include <type_traits>
-#include <typeinfo>
-#include <sstream>
-#include <memory>
-#if defined(__unix__) && __has_include(<cxxabi.h>)
-#include <cxxabi.h>
-#endif
+    using bin_scalars = std::tuple<bool, char, signed char, unsigned char,
+                                   char8_t, char16_t, char32_t, short,
+                                   unsigned short, int, unsigned int, long,
+                                   unsigned long, long long, unsigned long long,
+                                   float, double, long double>;
 
-struct debug {
-private:
-    std::ostringstream oss;
+    static_assert(std::is_trivially_copyable_v<std::source_location>);
+
+    template <class T, std::size_t I = 0>
+    static constexpr std::size_t bin_scalar_index() {
+        if constexpr (I == std::tuple_size_v<bin_scalars>) {
+            return I;
+        } else if constexpr (std::is_same_v<
+                                 T, std::tuple_element_t<I, bin_scalars>>) {
+            return I;
+        } else {
+            return bin_scalar_index<T, I + 1>();
+        }
+    }
+
+    // 短记录放在对象内，超出时转存到堆上
+    struct bin_buffer {
+        char small[192];
+        std::size_t size = 0;
+        std::string big;
+
+        void append(void const *p, std::size_t n) {
+            if (big.empty() && size + n <= sizeof(small)) [[likely]] {
+                std::memcpy(small + size, p, n);
+                size += n;
+                return;
+            }
+            if (big.empty()) {
+                big.assign(small, size);
+            }
+            big.append(static_cast<char const *>(p), n);
+        }
+
+        void append_tag(unsigned char tag) {
+            append(&tag, 1);
+        }
+
+        std::string_view view() const noexcept {
+            return big.empty() ? std::string_view(small, size) : big;
+        }
+    };
+
+    bin_buffer buf;
+#else
+    std::string text;
+#endif
 
     enum {
         silent = 0,
@@ -110,31 +219,164 @@ private:
     char const *line;
     std::source_location const &loc;
 
-    static void uni_quotes(std::ostream &oss, std::string_view sv, char quote) {
-        oss << quote;
-        for (char c: sv) {
+    // 每个线程保留几块用过的缓冲，对象构造时取出，析构时清空归还，
+    // 稳定运行后格式化不再分配内存
+    static std::vector<std::string> &uni_spares() noexcept {
+        static thread_local std::vector<std::string> spares;
+        return spares;
+    }
+
+    static std::string uni_acquire() noexcept {
+        auto &spares = uni_spares();
+        if (spares.empty()) {
+            return {};
+        }
+        std::string s = std::move(spares.back());
+        spares.pop_back();
+        return s;
+    }
+
+    static void uni_release(std::string &&s) noexcept {
+        auto &spares = uni_spares();
+        if (spares.size() < 8 && s.capacity() <= 65536) {
+            s.clear();
+            try {
+                spares.push_back(std::move(s));
+            } catch (...) {
+            }
+        }
+    }
+
+    // 仍需 std::ostream 的类型（用户的 operator<< 与 repr(std::ostream &)）
+    // 写到线程内复用的流中再拷出，流被占用（嵌套调用）时临时新建
+    template <class F>
+    static void uni_stream(std::string &out, F &&write) {
+        static thread_local std::ostringstream cached;
+        static thread_local bool busy = false;
+        if (busy) {
+            std::ostringstream oss;
+            write(static_cast<std::ostream &>(oss));
+            out += oss.view();
+            return;
+        }
+        struct guard {
+            ~guard() {
+                busy = false;
+            }
+        } g;
+        busy = true;
+        cached.str({});
+        cached.clear();
+        cached.flags(std::ios_base::dec | std::ios_base::skipws);
+        cached.precision(6);
+        cached.fill(' ');
+        write(static_cast<std::ostream &>(cached));
+        out += cached.view();
+    }
+
+    template <class... Args>
+    static void uni_chars(std::string &out, Args... args) {
+        char buf[64];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), args...);
+        if (ec == std::errc{}) [[likely]] {
+            out.append(buf, end);
+            return;
+        }
+        // 定点格式下的极大浮点数
+        std::size_t pos = out.size();
+        for (std::size_t n = 512;; n *= 2) {
+            out.resize(pos + n);
+            auto r = std::to_chars(out.data() + pos, out.data() + pos + n,
+                                   args...);
+            if (r.ec == std::errc{}) {
+                out.resize(static_cast<std::size_t>(r.ptr - out.data()));
+                return;
+            }
+        }
+    }
+
+    // 等价于 std::hex << std::setfill('0') << std::setw(width)，upper 对应
+    // std::uppercase
+    template <class T>
+    static void uni_hex(std::string &out, T v, std::size_t width,
+                        bool upper = true) {
+        char buf[sizeof(T) * 2];
+        auto end = std::to_chars(buf, buf + sizeof(buf), v, 16).ptr;
+        std::size_t n = static_cast<std::size_t>(end - buf);
+        if (n < width) {
+            out.append(width - n, '0');
+        }
+        if (upper) {
+            for (char *p = buf; p != end; ++p) {
+                if (*p >= 'a') {
+                    *p = static_cast<char>(*p - 'a' + 'A');
+                }
+            }
+        }
+        out.append(buf, n);
+    }
+
+    static bool uni_needs_escape(char c, char quote) noexcept {
+        return (c >= 0 && c < 0x20) || c == 0x7F || c == '\\' || c == quote;
+    }
+
+    // 返回第一个需要转义的字符，SSE2 下每次检查 16 字节
+    static char const *uni_plain_run(char const *p, char const *end,
+                                     char quote) noexcept {
+#if defined(__SSE2__)
+        __m128i const ctl = _mm_set1_epi8(0x1F);
+        __m128i const del = _mm_set1_epi8(0x7F);
+        __m128i const bsl = _mm_set1_epi8('\\');
+        __m128i const quo = _mm_set1_epi8(quote);
+        for (; end - p >= 16; p += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            // 无符号比较 v <= 0x1F：min(v, 0x1F) == v
+            __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v),
+                             _mm_cmpeq_epi8(v, del)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, bsl), _mm_cmpeq_epi8(v, quo)));
+            if (int bits = _mm_movemask_epi8(m)) {
+                return p + std::countr_zero(static_cast<unsigned>(bits));
+            }
+        }
+#endif
+        while (p != end && !uni_needs_escape(*p, quote)) {
+            ++p;
+        }
+        return p;
+    }
+
+    static void uni_quotes(std::string &out, std::string_view sv, char quote) {
+        out += quote;
+        char const *p = sv.data();
+        char const *end = p + sv.size();
+        while (true) {
+            char const *run = uni_plain_run(p, end, quote);
+            out.append(p, run);
+            if (run == end) {
+                break;
+            }
+            char c = *run;
+            p = run + 1;
             switch (c) {
-            case '\n': oss << "\\n"; break;
-            case '\r': oss << "\\r"; break;
-            case '\t': oss << "\\t"; break;
-            case '\\': oss << "\\\\"; break;
-            case '\0': oss << "\\0"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\\': out += "\\\\"; break;
+            case '\0': out += "\\0"; break;
             default:
-                if ((c >= 0 && c < 0x20) || c == 0x7F) {
-                    auto f = oss.flags();
-                    oss << "\\x" << std::hex << std::setfill('0')
-                        << std::setw(2) << static_cast<int>(c);
-                    oss.flags(f);
+                if (c == quote) {
+                    out += '\\';
+                    out += c;
                 } else {
-                    if (c == quote) {
-                        oss << '\\';
-                    }
-                    oss << c;
+                    out += "\\x";
+                    out += "0123456789abcdef"[(c >> 4) & 0xF];
+                    out += "0123456789abcdef"[c & 0xF];
                 }
                 break;
             }
         }
-        oss << quote;
+        out += quote;
     }
 
     static std::string uni_demangle(char const *name) {
@@ -149,64 +391,94 @@ private:
         return s;
     }
 
+    // std::ostream 经 operator<<(void const *) 输出为地址的指针类型；
+    // 指向各种字符类型的指针另有重载或重载被删除，仍交给 std::ostream 处理
+    template <class T>
+    static constexpr bool uni_is_address =
+        std::is_pointer_v<T> && std::is_convertible_v<T, void const *> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>,
+                        signed char> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>,
+                        unsigned char> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, wchar_t> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char8_t> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>,
+                        char16_t> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char32_t>;
+
+    // 与 std::ostream 输出 void const * 相同：空指针为 0，否则为 0x 加小写十六进制
+    static void uni_pointer(std::string &out, void const *p) {
+        if (p == nullptr) {
+            out += '0';
+        } else {
+            out += "0x";
+            uni_hex(out, reinterpret_cast<std::uintptr_t>(p), 0, false);
+        }
+    }
+
     template <class T0>
-    static void uni_format(std::ostream &oss, T0 &&t) {
+    static void uni_format(std::string &out, T0 &&t) {
         using T = std::decay_t<T0>;
         if constexpr (std::is_convertible_v<T, std::string_view> &&
                       !std::is_same_v<T, char const *>) {
-            uni_quotes(oss, t, '"');
+            uni_quotes(out, t, '"');
         } else if constexpr (std::is_same_v<T, bool>) {
-            auto f = oss.flags();
-            oss << std::boolalpha << t;
-            oss.flags(f);
+            out += t ? "true" : "false";
         } else if constexpr (std::is_same_v<T, char> ||
                              std::is_same_v<T, signed char>) {
-            uni_quotes(oss, {reinterpret_cast<char const *>(&t), 1}, '\'');
+            uni_quotes(out, {reinterpret_cast<char const *>(&t), 1}, '\'');
         } else if constexpr (std::is_same_v<T, char8_t> ||
                              std::is_same_v<T, char16_t> ||
                              std::is_same_v<T, char32_t>) {
-            auto f = oss.flags();
-            oss << "'\\"
-                << " xu U"[sizeof(T)] << std::hex << std::setfill('0')
-                << std::setw(sizeof(T) * 2) << std::uppercase
-                << static_cast<std::uint32_t>(t) << "'";
-            oss.flags(f);
+            out += "'\\";
+            out += " xu U"[sizeof(T)];
+            uni_hex(out, static_cast<std::uint32_t>(t), sizeof(T) * 2);
+            out += '\'';
         } else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>) {
-            auto f = oss.flags();
-            oss << "0x" << std::hex << std::setfill('0')
-                << std::setw(sizeof(T) * 2) << std::uppercase;
-            if constexpr (sizeof(T) == 1) {
-                oss << static_cast<unsigned int>(t);
-            } else {
-                oss << t;
-            }
-            oss.flags(f);
+            out += "0x";
+            uni_hex(out, t, sizeof(T) * 2);
+        } else if constexpr (std::is_integral_v<T>) {
+            // 包括 wchar_t，原先经 std::to_string 输出十进制
+            using W = std::conditional_t<(sizeof(T) > sizeof(long long)), T,
+                                         long long>;
+            uni_chars(out, static_cast<W>(t));
         } else if constexpr (std::is_floating_point_v<T>) {
-            auto f = oss.flags();
-            oss << std::fixed
-                << std::setprecision(std::numeric_limits<T>::digits10) << t;
-            oss.flags(f);
+            uni_chars(out, t, std::chars_format::fixed,
+                      std::numeric_limits<T>::digits10);
+        } else if constexpr (std::is_same_v<T, char const *>) {
+            // 空指针输出为空
+            if constexpr (std::is_pointer_v<std::remove_reference_t<T0>>) {
+                if (t == nullptr) {
+                    return;
+                }
+            }
+            out += t;
+        } else if constexpr (uni_is_address<T>) {
+            uni_pointer(out, t);
         } else if constexpr (requires(std::ostream &oss, T0 &&t) {
                                  oss << std::forward<T0>(t);
                              }) {
-            oss << std::forward<T0>(t);
+            uni_stream(out, [&](std::ostream &oss) {
+                oss << std::forward<T0>(t);
+            });
         } else if constexpr (requires(T0 &&t) {
                                  std::to_string(std::forward<T0>(t));
                              }) {
-            oss << std::to_string(std::forward<T0>(t));
+            out += std::to_string(std::forward<T0>(t));
         } else if constexpr (requires(T0 &&t) {
                                  std::begin(std::forward<T0>(t)) !=
                                      std::end(std::forward<T0>(t));
                              }) {
-            oss << '{';
+            out += '{';
             bool add_comma = false;
             for (auto &&i: t) {
                 if (add_comma)
-                    oss << ", ";
+                    out += ", ";
                 add_comma = true;
-                uni_format(oss, std::forward<decltype(i)>(i));
+                uni_format(out, std::forward<decltype(i)>(i));
             }
-            oss << '}';
+            out += '}';
         } else if constexpr (requires(T0 &&t) {
                                  /* []<std::size_t... Is>( */
                                  /*     T &&t, std::index_sequence<Is...>) { */
@@ -218,111 +490,231 @@ private:
                                      /* >{}) */
                                      ;
                              }) {
-            oss << '{';
+            out += '{';
             bool add_comma = false;
             std::apply(
                 [&](auto &&...args) {
                     (([&] {
                          if (add_comma)
-                             oss << ", ";
+                             out += ", ";
                          add_comma = true;
-                         (uni_format)(oss, std::forward<decltype(args)>(args));
+                         (uni_format)(out, std::forward<decltype(args)>(args));
                      }()),
                      ...);
                 },
                 t);
-            oss << '}';
+            out += '}';
         } else if constexpr (std::is_enum_v<T>) {
-            uni_format(oss, static_cast<std::underlying_type_t<T>>(t));
+            uni_format(out, static_cast<std::underlying_type_t<T>>(t));
         } else if constexpr (std::is_same_v<T, std::type_info>) {
-            oss << uni_demangle(t.name());
+            out += uni_demangle(t.name());
         } else if constexpr (requires(T0 &&t) { std::forward<T0>(t).repr(); }) {
-            uni_format(oss, std::forward<T0>(t).repr());
-        } else if constexpr (requires(T0 &&t) {
+            uni_format(out, std::forward<T0>(t).repr());
+        } else if constexpr (requires(std::ostream &oss, T0 &&t) {
                                  std::forward<T0>(t).repr(oss);
                              }) {
-            std::forward<T0>(t).repr(oss);
+            uni_stream(out, [&](std::ostream &oss) {
+                std::forward<T0>(t).repr(oss);
+            });
         } else if constexpr (requires(T0 &&t) { repr(std::forward<T0>(t)); }) {
-            uni_format(oss, repr(std::forward<T0>(t)));
-        } else if constexpr (requires(T0 &&t) {
+            uni_format(out, repr(std::forward<T0>(t)));
+        } else if constexpr (requires(std::ostream &oss, T0 &&t) {
                                  repr(oss, std::forward<T0>(t));
                              }) {
-            repr(oss, std::forward<T0>(t));
+            uni_stream(out, [&](std::ostream &oss) {
+                repr(oss, std::forward<T0>(t));
+            });
         } else if constexpr (requires(T0 const &t) {
                                  (*t);
                                  (bool)t;
                              }) {
             if ((bool)t) {
-                uni_format(oss, *t);
+                uni_format(out, *t);
             } else {
-                oss << "nil";
+                out += "nil";
             }
         } else if constexpr (requires(T0 const &t) {
                                  visit([](auto const &) {}, t);
                              }) {
-            visit([&oss](auto const &t) { uni_format(oss, t); }, t);
+            visit([&out](auto const &t) { uni_format(out, t); }, t);
         } else {
-            oss << '[' << uni_demangle(typeid(t).name()) << " at "
-                << reinterpret_cast<void const *>(std::addressof(t)) << ']';
+            out += '[';
+            out += uni_demangle(typeid(t).name());
+            out += " at ";
+            uni_pointer(out, std::addressof(t));
+            out += ']';
         }
     }
 
-    debug &add_location_marks() {
+    static void uni_location(std::string &out, std::source_location const &loc,
+                             char const *line) {
         char const *fn = loc.file_name();
         for (char const *fp = fn; *fp; ++fp) {
             if (*fp == '/') {
                 fn = fp + 1;
             }
         }
-        oss << fn << ':' << loc.line() << ':' << '\t';
+        out += fn;
+        out += ':';
+        uni_chars(out, loc.line());
+        out += ":\t";
         if (line) {
-            oss << '[' << line << ']' << '\t';
+            out += '[';
+            out += line;
+            out += "]\t";
         } else {
 #if DEBUG_SHOW_SOURCE
-            static thread_local std::unordered_map<std::string, std::string>
-                fileCache;
-            auto key = std::to_string(loc.line()) + loc.file_name();
-            if (auto it = fileCache.find(key);
-                it != fileCache.end() && !it->second.empty()) [[likely]] {
-                oss << '[' << it->second << ']';
-            } else if (auto file = std::ifstream(loc.file_name());
-                       file.is_open()) [[likely]] {
-                std::string line;
-                for (int i = 0; i < loc.line(); ++i) {
-                    if (!std::getline(file, line)) [[unlikely]] {
-                        line.clear();
-                        break;
-                    }
-                }
-                if (auto pos = line.find_first_not_of(" \t\r\n");
-                    pos != line.npos) [[likely]] {
-                    line = line.substr(pos);
+            if (auto src = debug_source::line(loc.file_name(), loc.line());
+                !src) [[unlikely]] {
+                out += "[?]";
+            } else {
+                std::string_view text = *src;
+                if (auto pos = text.find_first_not_of(" \t\r\n");
+                    pos != text.npos) [[likely]] {
+                    text.remove_prefix(pos);
                 }
-                if (!line.empty()) [[likely]] {
-                    if (line.back() == ';') [[likely]] {
-                        line.pop_back();
+                if (!text.empty()) [[likely]] {
+                    if (text.back() == ';') [[likely]] {
+                        text.remove_suffix(1);
                     }
-                    oss << '[' << line << ']';
+                    out += '[';
+                    out += text;
+                    out += ']';
                 }
-                fileCache.try_emplace(key, std::move(line));
-            } else {
-                oss << '[' << '?' << ']';
-                fileCache.try_emplace(key);
             }
 #endif
         }
-        oss << ' ';
+        out += ' ';
+    }
+
+#if DEBUG_BINARY
+    template <class T>
+    static char const *bin_decode_scalar(std::string &out, char const *p) {
+        T t;
+        std::memcpy(&t, p, sizeof(T));
+        uni_format(out, t);
+        return p + sizeof(T);
+    }
+
+    template <std::size_t... Is>
+    static char const *bin_decode_scalar(std::string &out, std::size_t index,
+                                         char const *p,
+                                         std::index_sequence<Is...>) {
+        ((index == Is ? (void)(p = bin_decode_scalar<
+                                   std::tuple_element_t<Is, bin_scalars>>(out, p))
+                      : void()),
+         ...);
+        return p;
+    }
+
+    static void bin_decode_text(std::string &out, std::string_view record) {
+        std::source_location loc;
+        char const *line;
+        char const *p = record.data();
+        char const *end = p + record.size();
+        std::memcpy(&loc, p, sizeof(loc));
+        p += sizeof(loc);
+        std::memcpy(&line, p, sizeof(line));
+        p += sizeof(line);
+        while (p < end) {
+            unsigned char tag = static_cast<unsigned char>(*p++);
+            if (tag == bin_marks) {
+                uni_location(out, loc, line);
+            } else if (tag == bin_space) {
+                out += ' ';
+            } else if (tag == bin_raw || tag == bin_quoted) {
+                std::uint32_t n;
+                std::memcpy(&n, p, sizeof(n));
+                p += sizeof(n);
+                std::string_view sv(p, n);
+                p += n;
+                if (tag == bin_raw) {
+                    out += sv;
+                } else {
+                    uni_quotes(out, sv, '"');
+                }
+            } else {
+                p = bin_decode_scalar(
+                    out, tag - bin_scalar, p,
+                    std::make_index_sequence<std::tuple_size_v<bin_scalars>>{});
+            }
+        }
+    }
+
+    static void bin_decode(std::string &out, char const *data,
+                           std::size_t size) {
+        bin_decode_text(out, {data, size});
+        out += '\n';
+    }
+
+    void bin_put_string(unsigned char tag, std::string_view sv) {
+        auto n = static_cast<std::uint32_t>(sv.size());
+        buf.append_tag(tag);
+        buf.append(&n, sizeof(n));
+        buf.append(sv.data(), n);
+    }
+#endif
+
+    debug_logger &add_location_marks() {
+#if DEBUG_BINARY
+        buf.append_tag(bin_marks);
+#else
+        uni_location(text, loc, line);
+#endif
         return *this;
     }
 
+    void put_space() {
+#if DEBUG_BINARY
+        buf.append_tag(bin_space);
+#else
+        text += ' ';
+#endif
+    }
+
+    void put_text(char const *msg) {
+#if DEBUG_BINARY
+        bin_put_string(bin_raw, msg);
+#else
+        text += msg;
+#endif
+    }
+
+    // 标量与字符串只记录原始字节，其余类型在调用方先格式化成文本
+    template <class T0>
+    void put_value(T0 &&t) {
+#if DEBUG_BINARY
+        using T = std::decay_t<T0>;
+        if constexpr (bin_scalar_index<T>() < std::tuple_size_v<bin_scalars>) {
+            T v = t;
+            buf.append_tag(
+                static_cast<unsigned char>(bin_scalar + bin_scalar_index<T>()));
+            buf.append(&v, sizeof(T));
+        } else if constexpr (std::is_convertible_v<T, std::string_view> &&
+                             !std::is_same_v<T, char const *>) {
+            bin_put_string(bin_quoted, std::string_view(t));
+        } else if constexpr (std::is_same_v<T, char const *>) {
+            char const *p = t;
+            bin_put_string(bin_raw, p != nullptr ? p : "");
+        } else {
+            std::string tmp;
+            uni_format(tmp, std::forward<T0>(t));
+            bin_put_string(bin_raw, tmp);
+        }
+#else
+        uni_format(text, std::forward<T0>(t));
+#endif
+    }
+
+
     template <class T>
     struct debug_condition {
     private:
-        debug &d;
+        debug_logger &d;
         T const &t;
 
         template <class U>
-        debug &check(bool cond, U const &u, char const *sym) {
+        debug_logger &check(bool cond, U const &u, char const *sym) {
             if (!cond) [[unlikely]] {
                 d.on_error("assertion failed:") << t << sym << u;
             }
@@ -330,74 +722,168 @@ private:
         }
 
     public:
-        explicit debug_condition(debug &d, T const &t) noexcept : d(d), t(t) {}
+        explicit debug_condition(debug_logger &d, T const &t) noexcept : d(d), t(t) {}
 
         template <class U>
-        debug &operator<(U const &u) {
+        debug_logger &operator<(U const &u) {
             return check(t < u, u, "<");
         }
 
         template <class U>
-        debug &operator>(U const &u) {
+        debug_logger &operator>(U const &u) {
             return check(t > u, u, ">");
         }
 
         template <class U>
-        debug &operator<=(U const &u) {
+        debug_logger &operator<=(U const &u) {
             return check(t <= u, u, "<=");
         }
 
         template <class U>
-        debug &operator>=(U const &u) {
+        debug_logger &operator>=(U const &u) {
             return check(t >= u, u, ">=");
         }
 
         template <class U>
-        debug &operator==(U const &u) {
+        debug_logger &operator==(U const &u) {
             return check(t == u, u, "==");
         }
 
         template <class U>
-        debug &operator!=(U const &u) {
+        debug_logger &operator!=(U const &u) {
             return check(t != u, u, "!=");
         }
     };
 
-    debug &on_error(char const *msg) {
-        if (state != supress) {
-            state = panic;
+    // 已关闭的对象不会输出，也不必记录
+    debug_logger &on_error(char const *msg) {
+        if (state == supress)
+            return *this;
+        state = panic;
+        add_location_marks();
+        put_text(msg);
+        return *this;
+    }
+
+    // 原样输出一段说明文字，不加引号
+    void on_print_text(char const *msg) {
+        if (state == silent) {
+            state = print;
             add_location_marks();
         } else {
-            oss << ' ';
+            put_space();
         }
-        oss << msg;
-        return *this;
+        put_text(msg);
     }
 
     template <class T>
-    debug &on_print(T &&t) {
+    debug_logger &on_print(T &&t) {
         if (state == supress)
             return *this;
         if (state == silent) {
             state = print;
             add_location_marks();
         } else {
-            oss << ' ';
+            put_space();
         }
-        uni_format(oss, std::forward<T>(t));
+        put_value(std::forward<T>(t));
         return *this;
     }
 
-public:
-    debug(bool enable = true, char const *line = nullptr,
-          std::source_location const &loc =
-              std::source_location::current()) noexcept
-        : state(enable ? silent : supress),
+    static int initial_level() noexcept {
+        char const *env = std::getenv("DEBUG_LEVEL");
+        if (env == nullptr) {
+            return DEBUG_MIN_LEVEL;
+        }
+        constexpr std::string_view names[] = {"trace", "debug", "info",
+                                               "warn",  "error", "off"};
+        for (int i = 0; i != static_cast<int>(std::size(names)); ++i) {
+            if (names[i] == env) {
+                return i;
+            }
+        }
+        return DEBUG_MIN_LEVEL;
+    }
+
+    static std::atomic<int> &runtime_level() noexcept {
+        static std::atomic<int> level{initial_level()};
+        return level;
+    }
+
+    // 一个调用点的限流状态，由 rate_limit 在调用点实例化的静态变量持有，常量初始化
+    struct site_state {
+        // 高 32 位为当前窗口所在的秒，低 32 位为窗口内的调用次数
+        // 初始计数已超出任何限额，第一次调用即读时钟开启窗口
+        // 窗口过期后、换成新窗口前到达的调用也会计入旧窗口，不能据此推算丢弃数
+        std::atomic<std::uint64_t> window{std::uint64_t(1) << 31};
+        // 上次注明以来实际被丢弃的调用数
+        std::atomic<std::uint32_t> suppressed{0};
+    };
+
+    // 限流窗口所在的秒，与 steady_clock 同一纪元
+    // 有粗粒度时钟时用它（vDSO 中直接读上一个时钟滴答的时间，约为 steady_clock 的
+    // 1/5 开销，滞后不超过一个滴答），窗口按秒划分不需要更高的精度
+    static std::uint32_t window_second() noexcept {
+#ifdef CLOCK_MONOTONIC_COARSE
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return static_cast<std::uint32_t>(ts.tv_sec);
+#else
+        return static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+#endif
+    }
+
+    static std::uint64_t uni_random() noexcept {
+        static thread_local std::uint64_t seed =
+            reinterpret_cast<std::uintptr_t>(&seed) ^
+            static_cast<std::uint64_t>(
+                std::chrono::steady_clock::now().time_since_epoch().count());
+        // splitmix64
+        std::uint64_t z = (seed += 0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        return z ^ (z >> 31);
+    }
+
+protected:
+    debug_logger(debug_level level, bool enable, char const *line,
+                 std::source_location const &loc) noexcept
+        : state(enable && enabled(level) ? silent : supress),
           line(line),
-          loc(loc) {}
+          loc(loc) {
+#if DEBUG_BINARY
+        buf.append(&loc, sizeof(loc));
+        buf.append(&line, sizeof(line));
+#else
+        if (state != supress) {
+            text = uni_acquire();
+        }
+#endif
+    }
+
+public:
+    debug_logger(debug_logger &&) = delete;
+    debug_logger(debug_logger const &) = delete;
+
+    // 运行期级别，初值取环境变量 DEBUG_LEVEL（trace、debug、info、warn、error、off），
+    // 未设置时为编译期最低级别；只能在编译期保留的范围内进一步过滤
+    static void set_level(debug_level level) noexcept {
+        runtime_level().store(static_cast<int>(level),
+                              std::memory_order_relaxed);
+    }
+
+    static debug_level level() noexcept {
+        return static_cast<debug_level>(
+            runtime_level().load(std::memory_order_relaxed));
+    }
 
-    debug(debug &&) = delete;
-    debug(debug const &) = delete;
+    static bool enabled(debug_level level) noexcept {
+        return static_cast<int>(level) >=
+               runtime_level().load(std::memory_order_relaxed);
+    }
 
     template <class T>
     debug_condition<T> check(T const &t) noexcept {
@@ -409,7 +895,7 @@ public:
         return debug_condition<T>{*this, t};
     }
 
-    debug &fail(bool fail = true) {
+    debug_logger &fail(bool fail = true) {
         if (fail) [[unlikely]] {
             on_error("error:");
         } else {
@@ -418,33 +904,132 @@ public:
         return *this;
     }
 
-    debug &on(bool enable) {
+    debug_logger &on(bool enable) {
         if (!enable) [[likely]] {
             state = supress;
         }
         return *this;
     }
 
+    // 本调用点每秒最多输出 per_second 条（小于 2^31），超出的在格式化之前丢弃；
+    // 新窗口的第一条记录开头注明此前丢弃的条数
+    // Site 默认为调用处的 lambda 类型，每个调用点各有一份静态状态，不必查表；
+    // 计数未超出限额时只有一次 relaxed 的 fetch_add，超出时才读时钟看窗口是否过期
+    // 过期窗口剩下的额度在读时钟前仍会用掉，所以一秒内最多可能输出 2 * per_second 条
+    template <class Site = decltype([] {})>
+    debug_logger &rate_limit(std::uint32_t per_second) {
+        static site_state site;
+        if (state == supress)
+            return *this;
+        std::uint64_t w = site.window.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (static_cast<std::uint32_t>(w) <= per_second) [[likely]] {
+            return *this;
+        }
+        auto now = window_second();
+        bool opened = false;
+        // 窗口已过期：把它换成新的一秒，换成功的调用负责注明丢弃数
+        // 其它线程先换过时，在新窗口中重新计数
+        while (static_cast<std::uint32_t>(w >> 32) < now) [[unlikely]] {
+            std::uint64_t fresh = std::uint64_t(now) << 32 | 1;
+            if (site.window.compare_exchange_weak(w, fresh,
+                                                  std::memory_order_relaxed)) {
+                opened = true;
+                w = fresh;
+            } else if (static_cast<std::uint32_t>(w >> 32) >= now) {
+                w = site.window.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+        }
+        if (static_cast<std::uint32_t>(w) > per_second) {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            state = supress;
+        } else if (opened) [[unlikely]] {
+            std::uint32_t dropped =
+                site.suppressed.exchange(0, std::memory_order_relaxed);
+            if (dropped != 0) {
+                char note[48] = "[debug: ";
+                char *end =
+                    std::to_chars(note + 8, note + sizeof(note), dropped).ptr;
+                std::memcpy(end, " lines suppressed]", 19);
+                on_print_text(note);
+            }
+        }
+        return *this;
+    }
+
+    // 以 1/k 的概率保留本条记录，不涉及共享状态
+    debug_logger &sample(std::uint32_t k) {
+        if (state == supress || k <= 1)
+            return *this;
+        if (((uni_random() >> 32) * k >> 32) != 0) {
+            state = supress;
+        }
+        return *this;
+    }
+
     template <class T>
-    debug &operator<<(T &&t) {
+    debug_logger &operator<<(T &&t) {
         return on_print(std::forward<T>(t));
     }
 
     template <class T>
-    debug &operator,(T &&t) {
+    debug_logger &operator,(T &&t) {
         return on_print(std::forward<T>(t));
     }
 
-    ~debug() noexcept(false) {
+    ~debug_logger() noexcept(false) {
+#if DEBUG_BINARY
         if (state == panic) [[unlikely]] {
-            throw std::runtime_error(oss.str());
+            std::string msg;
+            bin_decode_text(msg, buf.view());
+            throw std::runtime_error(msg);
         }
         if (state == print) {
-            oss << '\n';
-            std::cerr << oss.str();
+            debug_async::submit(buf.view(), bin_decode);
+        }
+#else
+        if (state == panic) [[unlikely]] {
+            throw std::runtime_error(text);
         }
+        if (state == print) {
+            text += '\n';
+#if DEBUG_ASYNC
+            debug_async::submit(text);
+#else
+            std::cerr.write(text.data(),
+                            static_cast<std::streamsize>(text.size()));
+#endif
+        }
+        uni_release(std::move(text));
+#endif
     }
 };
 
+// 按编译期最低级别选择实现，Level 低于 DEBUG_MIN_LEVEL 时整个类型为空操作
+template <debug_level Level>
+struct debug_at : debug_logger {
+    debug_at(bool enable = true, char const *line = nullptr,
+             std::source_location const &loc =
+                 std::source_location::current()) noexcept
+        : debug_logger(Level, enable, line, loc) {}
+};
+
+template <debug_level Level>
+using basic_debug =
+    std::conditional_t<(static_cast<int>(Level) >= DEBUG_MIN_LEVEL),
+                       debug_at<Level>, debug_null>;
 
-#endif
+using debug_trace = basic_debug<debug_level::trace>;
+using debug = basic_debug<debug_level::debug>;
+using debug_info = basic_debug<debug_level::info>;
+using debug_warn = basic_debug<debug_level::warn>;
+using debug_error = basic_debug<debug_level::error>;
+
+// 与 debug_xxx() 相同，但被过滤掉时连参数也不求值：
+// 低于编译期最低级别时整条语句被丢弃，低于运行期级别时只做一次比较
+//   DEBUG_LOG(info), "queue size", expensive_count();
+// 展开后每个 if 都带有 else，可以安全地写在 if/else 的分支中
+#define DEBUG_LOG(level)                                                      \
+    if constexpr (static_cast<int>(debug_level::level) < DEBUG_MIN_LEVEL) {   \
+    } else if (!debug_logger::enabled(debug_level::level)) {                 \
+    } else                                                                    \
+        basic_debug<debug_level::level>()
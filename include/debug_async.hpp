@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#if __has_include(<sys/uio.h>) && __has_include(<unistd.h>)
+#include <sys/uio.h>
+#include <unistd.h>
+#define DEBUG_ASYNC_WRITEV 1
+#endif
+#if __has_include(<linux/futex.h>) && __has_include(<sys/syscall.h>) && \
+    __has_include(<unistd.h>)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define DEBUG_ASYNC_FUTEX 1
+#endif
+
+// debug 的异步输出后端（DEBUG_ASYNC 时启用）
+// 每个线程一个单生产者单消费者的字节环，submit 只做一次拷贝，从不阻塞：
+// 环满时整条丢弃并计数；后台线程批量用 writev 写出所有线程的环
+// 后台线程在某个环由空变为非空时被唤醒，空闲时只以逐渐拉长的间隔醒来；
+// 唤醒直接对 futex 发系统调用，不经过互斥量，没有 futex 的平台只按间隔轮询
+// 也可在事件循环空闲时调用 flush() 主动写出
+// 线程的环分配失败、或进程已开始退出时，submit 退回同步写出
+// 记录可以是已格式化的文本，也可以是附带解码函数的二进制数据，
+// 后者由后台线程调用解码函数格式化后再写出
+struct debug_async {
+    // 把二进制记录格式化并追加到 out
+    using decoder = void (*)(std::string &out, char const *data,
+                             std::size_t size);
+
+private:
+    static constexpr std::size_t ring_bytes = std::size_t(1) << 16;
+    static constexpr std::size_t max_iov = 1024;
+    // 空闲时后台线程的等待间隔，从最小值起逐次加倍，直到最大值
+    static constexpr std::chrono::milliseconds min_backoff{1};
+    static constexpr std::chrono::milliseconds max_backoff{1000};
+
+    struct frame {
+        std::uint32_t size;
+        decoder decode;
+    };
+
+    struct ring {
+        alignas(64) std::atomic<std::size_t> head{0};
+        alignas(64) std::atomic<std::size_t> tail{0};
+        std::atomic<bool> retired{false};
+        char data[ring_bytes];
+
+        void copy_in(std::size_t pos, void const *src, std::size_t n) noexcept {
+            std::size_t begin = pos % ring_bytes;
+            std::size_t first = std::min(n, ring_bytes - begin);
+            std::memcpy(data + begin, src, first);
+            std::memcpy(data, static_cast<char const *>(src) + first, n - first);
+        }
+
+        void copy_out(std::size_t pos, void *dst, std::size_t n) const noexcept {
+            std::size_t begin = pos % ring_bytes;
+            std::size_t first = std::min(n, ring_bytes - begin);
+            std::memcpy(dst, data + begin, first);
+            std::memcpy(static_cast<char *>(dst) + first, data, n - first);
+        }
+    };
+
+#if DEBUG_ASYNC_WRITEV
+    using iov_type = struct iovec;
+#else
+    struct iov_type {
+        void *iov_base;
+        std::size_t iov_len;
+    };
+#endif
+
+    struct state {
+        std::mutex registry_mutex;
+        std::vector<std::unique_ptr<ring>> rings;
+        std::mutex flush_mutex;
+        std::atomic<std::size_t> dropped{0};
+        std::size_t reported = 0;
+        std::atomic<bool> stopping{false};
+        // 上次清除以来是否有环由空变为非空（或有记录被丢弃），非零即是
+        // 32 位以便直接作为 futex 字
+        std::atomic<std::uint32_t> pending{0};
+        std::thread flusher;
+        int fd = 2;
+
+        state() {
+            flusher = std::thread([this] {
+                auto backoff = min_backoff;
+                while (!stopping.load(std::memory_order_acquire)) {
+                    if (flush_once()) {
+                        backoff = min_backoff;
+                        continue;
+                    }
+                    // 写空后才重新接受通知，繁忙期间生产者不必唤醒；
+                    // 交换而不是存储：与 notify 的交换同步，再写一次以免漏掉其间的记录
+                    pending.exchange(0, std::memory_order_acq_rel);
+                    if (flush_once()) {
+                        continue;
+                    }
+                    if (wait_pending(backoff)) {
+                        // 被唤醒后先攒一批再写，避免每条记录都切换一次线程
+                        std::this_thread::sleep_for(min_backoff);
+                        backoff = min_backoff;
+                    } else {
+                        backoff = std::min(backoff * 2, max_backoff);
+                    }
+                }
+            });
+            // state 有意不析构，退出时由此停下后台线程并写出剩余记录
+            std::atexit([] { global().shutdown(); });
+        }
+
+        void shutdown() {
+            stopping.store(true, std::memory_order_release);
+            pending.store(1, std::memory_order_release);
+            wake_flusher();
+            flusher.join();
+            while (flush_once()) {
+            }
+        }
+
+        // 只在没有待处理通知时唤醒，繁忙时生产者不进入内核；从不阻塞
+        void notify() noexcept {
+            if (pending.exchange(1, std::memory_order_acq_rel) == 0) {
+                wake_flusher();
+            }
+        }
+
+        void wake_flusher() noexcept {
+#if DEBUG_ASYNC_FUTEX
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&pending),
+                      FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+        }
+
+        // 等到有通知或超时，返回是否有通知（或正在退出）
+        // 被信号打断时提前返回，只当作一次超时
+        bool wait_pending(std::chrono::milliseconds timeout) noexcept {
+#if DEBUG_ASYNC_FUTEX
+            static_assert(sizeof(pending) == sizeof(std::uint32_t));
+            timespec ts{};
+            ts.tv_sec = static_cast<std::time_t>(timeout.count() / 1000);
+            ts.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000;
+            // 字已不为 0 时内核立即返回，不会漏掉其间的通知
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&pending),
+                      FUTEX_WAIT_PRIVATE, 0, &ts, nullptr, 0);
+#else
+            std::this_thread::sleep_for(timeout);
+#endif
+            return pending.load(std::memory_order_acquire) != 0 ||
+                   stopping.load(std::memory_order_acquire);
+        }
+
+        ring *attach() {
+            auto r = std::make_unique<ring>();
+            ring *p = r.get();
+            std::lock_guard lock(registry_mutex);
+            rings.push_back(std::move(r));
+            return p;
+        }
+
+        // 写出所有环中已提交的记录，返回是否写出了内容
+        bool flush_once() {
+            std::lock_guard flush_lock(flush_mutex);
+            std::vector<ring *> snapshot;
+            {
+                std::lock_guard lock(registry_mutex);
+                snapshot.reserve(rings.size());
+                for (auto &r: rings) {
+                    snapshot.push_back(r.get());
+                }
+            }
+
+            bool wrote = false;
+            std::size_t drops = dropped.load(std::memory_order_relaxed);
+            if (drops != reported) {
+                std::string note = "[debug: " +
+                                   std::to_string(drops - reported) +
+                                   " records dropped]\n";
+                write_all(note.data(), note.size());
+                reported = drops;
+                wrote = true;
+            }
+
+            struct pending {
+                ring *r;
+                std::size_t upto;
+            };
+            std::vector<pending> batch;
+            // 解码得到的文本，deque 追加时不移动已有元素，iov 可直接引用
+            std::deque<std::string> decoded;
+            std::string scratch;
+            iov_type iov[max_iov];
+            std::size_t niov = 0;
+            for (ring *r: snapshot) {
+                std::size_t pos = r->tail.load(std::memory_order_relaxed);
+                std::size_t head = r->head.load(std::memory_order_acquire);
+                std::size_t start = pos;
+                while (pos != head && niov + 2 <= max_iov) {
+                    frame f;
+                    r->copy_out(pos, &f, sizeof(f));
+                    std::size_t begin = (pos + sizeof(f)) % ring_bytes;
+                    std::size_t first = std::min<std::size_t>(
+                        f.size, ring_bytes - begin);
+                    if (f.decode == nullptr) {
+                        if (first != 0) {
+                            iov[niov++] = {r->data + begin, first};
+                        }
+                        if (first < f.size) {
+                            iov[niov++] = {r->data, f.size - first};
+                        }
+                    } else {
+                        char const *payload = r->data + begin;
+                        if (first < f.size) {
+                            scratch.resize(f.size);
+                            r->copy_out(pos + sizeof(f), scratch.data(),
+                                        f.size);
+                            payload = scratch.data();
+                        }
+                        std::string &text = decoded.emplace_back();
+                        f.decode(text, payload, f.size);
+                        iov[niov++] = {text.data(), text.size()};
+                    }
+                    pos += sizeof(f) + f.size;
+                }
+                if (pos != start) {
+                    batch.push_back({r, pos});
+                }
+            }
+
+            if (!batch.empty()) {
+                write_iov(iov, niov);
+                for (auto &p: batch) {
+                    p.r->tail.store(p.upto, std::memory_order_release);
+                }
+                wrote = true;
+            }
+
+            // 线程已退出且环已写空的，回收
+            std::lock_guard lock(registry_mutex);
+            std::erase_if(rings, [](std::unique_ptr<ring> const &r) {
+                return r->retired.load(std::memory_order_acquire) &&
+                       r->head.load(std::memory_order_acquire) ==
+                           r->tail.load(std::memory_order_relaxed);
+            });
+            return wrote;
+        }
+
+        void write_iov(iov_type *iov, std::size_t niov) {
+#if DEBUG_ASYNC_WRITEV
+            std::size_t total = 0;
+            for (std::size_t i = 0; i < niov; ++i) {
+                total += iov[i].iov_len;
+            }
+            ssize_t n = ::writev(fd, iov, static_cast<int>(niov));
+            // 部分写出时剩余部分逐段补写，保证记录完整
+            if (n >= 0 && static_cast<std::size_t>(n) < total) {
+                std::size_t skip = static_cast<std::size_t>(n);
+                for (std::size_t i = 0; i < niov; ++i) {
+                    auto *base = static_cast<char const *>(iov[i].iov_base);
+                    std::size_t len = iov[i].iov_len;
+                    if (skip >= len) {
+                        skip -= len;
+                        continue;
+                    }
+                    write_all(base + skip, len - skip);
+                    skip = 0;
+                }
+            }
+#else
+            for (std::size_t i = 0; i < niov; ++i) {
+                write_all(static_cast<char const *>(iov[i].iov_base),
+                          iov[i].iov_len);
+            }
+#endif
+        }
+
+        void write_all(char const *p, std::size_t n) {
+            while (n != 0) {
+#if DEBUG_ASYNC_WRITEV
+                ssize_t w = ::write(fd, p, n);
+                if (w <= 0) {
+                    return;
+                }
+#else
+                std::size_t w = std::fwrite(p, 1, n, stderr);
+                if (w == 0) {
+                    return;
+                }
+#endif
+                p += w;
+                n -= static_cast<std::size_t>(w);
+            }
+        }
+    };
+
+    // 有意不析构：静态对象析构期间仍可能有日志，退出时的收尾由 shutdown 完成
+    static state &global() {
+        static state *s = new state;
+        return *s;
+    }
+
+    struct thread_ring {
+        ring *r = nullptr;
+
+        // 分配失败时返回空，下次 submit 再试
+        ring *attach() noexcept {
+            try {
+                state &g = global();
+                if (!g.stopping.load(std::memory_order_acquire)) {
+                    r = g.attach();
+                }
+            } catch (...) {
+            }
+            return r;
+        }
+
+        ~thread_ring() {
+            if (r != nullptr) {
+                r->retired.store(true, std::memory_order_release);
+                r = nullptr;
+            }
+        }
+    };
+
+    // 不经过环，在调用线程上直接写出
+    static void write_now(std::string_view record, decoder decode) noexcept {
+        try {
+            state &g = global();
+            std::lock_guard lock(g.flush_mutex);
+            if (decode == nullptr) {
+                g.write_all(record.data(), record.size());
+            } else {
+                std::string text;
+                decode(text, record.data(), record.size());
+                g.write_all(text.data(), text.size());
+            }
+        } catch (...) {
+            // 连同步写出所需的内存也没有时只能放弃这一条
+        }
+    }
+
+public:
+    // 提交一条完整记录，环中空间不足时丢弃
+    // decode 为空表示 record 是已格式化的文本
+    static void submit(std::string_view record,
+                       decoder decode = nullptr) noexcept {
+        static thread_local thread_ring local;
+        ring *r = local.r;
+        if (r == nullptr) [[unlikely]] {
+            r = local.attach();
+            if (r == nullptr) {
+                write_now(record, decode);
+                return;
+            }
+        }
+        state &g = global();
+        if (g.stopping.load(std::memory_order_acquire)) [[unlikely]] {
+            write_now(record, decode);
+            return;
+        }
+        std::size_t head = r->head.load(std::memory_order_relaxed);
+        std::size_t tail = r->tail.load(std::memory_order_acquire);
+        if (sizeof(frame) + record.size() > ring_bytes - (head - tail))
+            [[unlikely]] {
+            g.dropped.fetch_add(1, std::memory_order_relaxed);
+            g.notify();
+            return;
+        }
+        frame f{static_cast<std::uint32_t>(record.size()), decode};
+        r->copy_in(head, &f, sizeof(f));
+        r->copy_in(head + sizeof(f), record.data(), record.size());
+        r->head.store(head + sizeof(f) + record.size(),
+                      std::memory_order_release);
+        if (head == tail) {
+            g.notify();
+        }
+    }
+
+    // 立即写出各线程到此为止已提交的记录
+    static void flush() {
+        global().flush_once();
+    }
+
+    // 累计丢弃的记录数
+    static std::size_t dropped() noexcept {
+        return global().dropped.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && \
+    __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DEBUG_SOURCE_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+// DEBUG_SHOW_SOURCE 使用的源码行缓存
+// 每个源文件只映射一次并建好行首偏移表，所有线程共享；
+// 线程内再按 file_name() 的指针缓存查找结果，命中时只有一次哈希查找，
+// 不加锁、不分配内存，也没有文件读写
+struct debug_source {
+private:
+    struct file {
+        std::string name;
+        char const *data = nullptr;
+        std::size_t size = 0;
+        // 第 i 行（从 0 起）的起始偏移
+        std::vector<std::size_t> lines;
+        bool ok = false;
+#if !DEBUG_SOURCE_MMAP
+        std::string storage;
+#endif
+
+        explicit file(char const *name) : name(name) {
+#if DEBUG_SOURCE_MMAP
+            int fd = ::open(name, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            struct stat st;
+            if (::fstat(fd, &st) == 0) {
+                size = static_cast<std::size_t>(st.st_size);
+                if (size == 0) {
+                    ok = true;
+                } else if (void *p = ::mmap(nullptr, size, PROT_READ,
+                                            MAP_PRIVATE, fd, 0);
+                           p != MAP_FAILED) {
+                    data = static_cast<char const *>(p);
+                    ok = true;
+                }
+            }
+            ::close(fd);
+#else
+            std::ifstream in(name, std::ios::binary);
+            if (!in.is_open()) {
+                return;
+            }
+            storage.assign(std::istreambuf_iterator<char>(in),
+                           std::istreambuf_iterator<char>());
+            data = storage.data();
+            size = storage.size();
+            ok = true;
+#endif
+            if (!ok) {
+                return;
+            }
+            lines.push_back(0);
+            for (char const *p = data, *end = data + size;
+                 (p = static_cast<char const *>(
+                      std::memchr(p, '\n', static_cast<std::size_t>(end - p))));
+                 ++p) {
+                lines.push_back(static_cast<std::size_t>(p - data) + 1);
+            }
+        }
+
+        file(file &&) = delete;
+
+        ~file() {
+#if DEBUG_SOURCE_MMAP
+            if (data != nullptr) {
+                ::munmap(const_cast<char *>(data), size);
+            }
+#endif
+        }
+
+        // 与逐行 getline 到第 n 行的结果相同：超出文件末尾时为空
+        std::string_view line(std::uint_least32_t n) const noexcept {
+            if (n == 0 || n > lines.size()) {
+                return {};
+            }
+            std::size_t begin = lines[n - 1];
+            std::size_t end = n < lines.size() ? lines[n] - 1 : size;
+            return {data + begin, end - begin};
+        }
+    };
+
+    struct state {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string_view, std::unique_ptr<file>> files;
+    };
+
+    // 有意不析构：静态对象析构期间仍可能有输出引用这些映射
+    static state &global() {
+        static state *s = new state;
+        return *s;
+    }
+
+    static file const *load(char const *name) {
+        state &g = global();
+        {
+            std::shared_lock lock(g.mutex);
+            if (auto it = g.files.find(name); it != g.files.end()) {
+                return it->second.get();
+            }
+        }
+        // 在锁外映射文件，并发加载同一文件时只保留先插入的一份
+        auto f = std::make_unique<file>(name);
+        std::string_view key = f->name;
+        std::unique_lock lock(g.mutex);
+        return g.files.try_emplace(key, std::move(f)).first->second.get();
+    }
+
+public:
+    // 返回源文件第 line 行（从 1 起，不含换行符），文件无法打开时返回空
+    static std::optional<std::string_view>
+    line(char const *name, std::uint_least32_t line) {
+        // 同一文件在不同翻译单元中 file_name() 的指针可能不同，
+        // 这里只做线程内的快速索引，共享表仍按文件名查找
+        static thread_local std::unordered_map<char const *, file const *>
+            local;
+        auto [it, inserted] = local.try_emplace(name, nullptr);
+        if (inserted) {
+            it->second = load(name);
+        }
+        if (!it->second->ok) {
+            return std::nullopt;
+        }
+        return it->second->line(line);
+    }
+};
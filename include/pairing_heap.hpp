@@ -0,0 +1,167 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+// 侵入式配对堆，接口与 RbTree 一致：insert、erase、front、pop_front、empty
+// insert O(1)，pop_front、erase 均摊 O(log n)
+// 结点不保存堆指针，析构前须先 erase（可用 is_linked() 判断）
+// 与 RbTree 不同，键相等的元素取出顺序不确定
+template <class Value, class Compare = std::less<Value>>
+struct PairingHeap {
+    struct PairingNode {
+        PairingNode() noexcept
+            : child(nullptr),
+              sibling(nullptr),
+              prev(nullptr) {}
+
+        PairingNode(PairingNode &&) = delete;
+
+        bool is_linked() const noexcept {
+            return prev != nullptr;
+        }
+
+        friend struct PairingHeap;
+
+    private:
+        // 第一个孩子
+        PairingNode *child;
+        // 右兄弟
+        PairingNode *sibling;
+        // 是第一个孩子时指向父结点，否则指向左兄弟；堆顶指向自身
+        PairingNode *prev;
+    };
+
+    using Node = PairingNode;
+
+private:
+    PairingNode *root;
+    Compare comp;
+
+    bool compare(PairingNode *left, PairingNode *right) const noexcept {
+        return comp(static_cast<Value &>(*left), static_cast<Value &>(*right));
+    }
+
+    // 合并两棵堆，较大的根成为较小的根的第一个孩子
+    PairingNode *doMeld(PairingNode *first, PairingNode *second) noexcept {
+        if (compare(second, first)) {
+            std::swap(first, second);
+        }
+        second->sibling = first->child;
+        if (first->child != nullptr) {
+            first->child->prev = second;
+        }
+        second->prev = first;
+        first->child = second;
+        return first;
+    }
+
+    // 两趟合并：先从左到右两两合并，再从右到左依次合并
+    PairingNode *mergePairs(PairingNode *first) noexcept {
+        // 第一趟的结果借 sibling 串成一个栈
+        PairingNode *stack = nullptr;
+        while (first != nullptr) {
+            PairingNode *second = first->sibling;
+            if (second == nullptr) {
+                first->sibling = stack;
+                stack = first;
+                break;
+            }
+            PairingNode *next = second->sibling;
+            first->sibling = nullptr;
+            second->sibling = nullptr;
+            PairingNode *merged = doMeld(first, second);
+            merged->sibling = stack;
+            stack = merged;
+            first = next;
+        }
+
+        PairingNode *result = nullptr;
+        while (stack != nullptr) {
+            PairingNode *next = stack->sibling;
+            stack->sibling = nullptr;
+            result = result != nullptr ? doMeld(stack, result) : stack;
+            stack = next;
+        }
+        return result;
+    }
+
+    void setRoot(PairingNode *node) noexcept {
+        root = node;
+        if (root != nullptr) {
+            root->prev = root;
+            root->sibling = nullptr;
+        }
+    }
+
+    static void resetNode(PairingNode *node) noexcept {
+        node->child = nullptr;
+        node->sibling = nullptr;
+        node->prev = nullptr;
+    }
+
+    void doInsert(PairingNode *node) noexcept {
+        node->child = nullptr;
+        node->sibling = nullptr;
+        node->prev = nullptr;
+        setRoot(root != nullptr ? doMeld(root, node) : node);
+    }
+
+    void doErase(PairingNode *node) noexcept {
+        if (node == root) {
+            setRoot(mergePairs(node->child));
+            resetNode(node);
+            return;
+        }
+
+        // 从父结点的孩子链表中摘下，其孩子合并后再与堆顶合并
+        if (node->prev->child == node) {
+            node->prev->child = node->sibling;
+        } else {
+            node->prev->sibling = node->sibling;
+        }
+        if (node->sibling != nullptr) {
+            node->sibling->prev = node->prev;
+        }
+
+        PairingNode *subtree = mergePairs(node->child);
+        if (subtree != nullptr) {
+            setRoot(doMeld(root, subtree));
+        }
+        resetNode(node);
+    }
+
+public:
+    PairingHeap() noexcept : root(nullptr) {}
+
+    explicit PairingHeap(Compare comp) noexcept(noexcept(Compare(comp)))
+        : root(nullptr),
+          comp(comp) {}
+
+    PairingHeap(PairingHeap &&) = delete;
+
+    ~PairingHeap() noexcept {}
+
+    void insert(Value &value) noexcept {
+        doInsert(&static_cast<PairingNode &>(value));
+    }
+
+    void erase(Value &value) noexcept {
+        doErase(&static_cast<PairingNode &>(value));
+    }
+
+    bool empty() const noexcept {
+        return root == nullptr;
+    }
+
+    Value &front() const noexcept {
+        return static_cast<Value &>(*root);
+    }
+
+    // 取出并删除最小结点，堆不能为空
+    Value &pop_front() noexcept {
+        PairingNode *node = root;
+        doErase(node);
+        return static_cast<Value &>(*node);
+    }
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <rbtree.hpp>
+#include <slab_pool.hpp>
+
+// 拥有元素的有序表（键唯一），以侵入式 RbTree 为索引
+// 键、值与树结点同在一个元素中，元素从 SlabPool 分配：
+// 除偶尔整块申请外没有逐元素的 malloc，emplace 只在键不存在时构造值
+// 迭代器解引用得到 Entry&，其 key、value 即键与值
+template <class Key, class Value, class Compare = std::less<Key>>
+struct RbMap {
+    struct Entry;
+
+private:
+    // 元素之间、元素与键之间的比较都转给 Compare
+    struct EntryCompare {
+        using is_transparent = void;
+
+        Compare comp;
+
+        bool operator()(Entry const &lhs, Entry const &rhs) const {
+            return comp(lhs.key, rhs.key);
+        }
+
+        template <class K>
+        bool operator()(Entry const &lhs, K const &rhs) const {
+            return comp(lhs.key, rhs);
+        }
+
+        template <class K>
+        bool operator()(K const &lhs, Entry const &rhs) const {
+            return comp(lhs, rhs.key);
+        }
+    };
+
+    using Tree = RbTree<Entry, EntryCompare, false>;
+
+public:
+    struct Entry : Tree::RbNode {
+        template <class... Args>
+        Entry(Key const &key, Args &&...args)
+            : key(key),
+              value(std::forward<Args>(args)...) {}
+
+        Key const key;
+        Value value;
+    };
+
+    using iterator = typename Tree::iterator;
+
+private:
+    Tree tree;
+    SlabPool<Entry> pool;
+    std::size_t count;
+
+    template <class K>
+    static constexpr bool isKeyComparable =
+        std::is_same_v<K, Key> ||
+        requires { typename Compare::is_transparent; };
+
+public:
+    RbMap() : count(0) {}
+
+    explicit RbMap(Compare comp) : tree(EntryCompare{comp}), count(0) {}
+
+    RbMap(RbMap &&) = delete;
+
+    ~RbMap() noexcept {
+        clear();
+    }
+
+    // 键不存在时用 args 构造值并插入，返回新元素和 true；
+    // 键已存在时不构造，返回已有元素和 false
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Key const &key, Args &&...args) {
+        typename Tree::insert_commit_data data;
+        auto [it, absent] = tree.insert_check(key, data);
+        if (!absent) {
+            return {it, false};
+        }
+        Entry *entry = pool.create(key, std::forward<Args>(args)...);
+        tree.insert_commit(*entry, data);
+        ++count;
+        return {tree.iterator_to(*entry), true};
+    }
+
+    // 删除并返回下一个元素的迭代器
+    iterator erase(iterator pos) noexcept {
+        Entry &entry = *pos++;
+        tree.erase(entry);
+        pool.destroy(&entry);
+        --count;
+        return pos;
+    }
+
+    // 返回删除的元素个数（0 或 1）
+    template <class K>
+        requires isKeyComparable<K>
+    std::size_t erase(K const &key) noexcept {
+        iterator it = tree.find(key);
+        if (it == tree.end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    void clear() noexcept {
+        tree.clear_and_dispose([this](Entry &entry) { pool.destroy(&entry); });
+        pool.release();
+        count = 0;
+    }
+
+    bool empty() const noexcept {
+        return tree.empty();
+    }
+
+    std::size_t size() const noexcept {
+        return count;
+    }
+
+    // 最小、最大元素，表不能为空
+    Entry &front() const noexcept {
+        return tree.front();
+    }
+
+    Entry &back() const noexcept {
+        return tree.back();
+    }
+
+    iterator begin() const noexcept {
+        return tree.begin();
+    }
+
+    iterator end() const noexcept {
+        return tree.end();
+    }
+
+    template <class K>
+        requires isKeyComparable<K>
+    iterator find(K const &key) const noexcept {
+        return tree.find(key);
+    }
+
+    template <class K>
+        requires isKeyComparable<K>
+    iterator lower_bound(K const &key) const noexcept {
+        return tree.lower_bound(key);
+    }
+
+    template <class K>
+        requires isKeyComparable<K>
+    iterator upper_bound(K const &key) const noexcept {
+        return tree.upper_bound(key);
+    }
+};
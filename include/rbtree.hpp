@@ -1,313 +1,893 @@
 #pragma once
 
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <concepts>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <type_traits>
 #include <utility>
 
-template <class Value, class Compare = std::less<Value>>
+// 结点附加信息（增强）策略：每个结点保存其子树的聚合值 type，
+// 由 value 取单个元素的值，再按中序用 combine 合并，identity 为单位元。
+// 若还提供 size(type)，即可用于 rank/select。
+struct RbNoAugment {
+    struct type {};
+};
+
+// 子树大小，支持 rank/select
+struct RbSizeAugment {
+    using type = std::size_t;
+
+    static type identity() noexcept {
+        return 0;
+    }
+
+    template <class Value>
+    static type value(Value const &) noexcept {
+        return 1;
+    }
+
+    static type combine(type lhs, type rhs) noexcept {
+        return lhs + rhs;
+    }
+
+    static std::size_t size(type sum) noexcept {
+        return sum;
+    }
+};
+
+// 区间树：元素为左闭右开区间 [start, end)，树按 start 排序（由 Compare 决定），
+// 每个结点保存子树中最大的 end，供 for_each_overlapping 剪枝
+// EndOf 为无状态的投影，EndOf{}(value) 取元素的 end
+template <class Endpoint, class EndOf>
+struct RbIntervalAugment {
+    using type = Endpoint;
+
+    static constexpr bool isInterval = true;
+
+    static type identity() noexcept {
+        return std::numeric_limits<Endpoint>::lowest();
+    }
+
+    template <class Value>
+    static type value(Value const &value) noexcept {
+        return EndOf{}(value);
+    }
+
+    static type combine(type lhs, type rhs) noexcept {
+        return lhs < rhs ? rhs : lhs;
+    }
+};
+
+// 可重复键的有序容器，键相等的元素保持插入的先后顺序（稳定）：
+// insert 把新元素排在等键元素之后，erase 以中序后继顶替、旋转不改变中序，
+// assign_sorted、split、join 也都保持已有的先后顺序
+// AutoUnlink 为 true 时结点保存所属树的指针，析构时自动从树中摘除；
+// 为 false 时结点只有三个指针大小，由使用者保证析构前已经 erase
+template <class Value,
+          class Compare = std::less<Value>,
+          bool AutoUnlink = true,
+          class Augment = RbNoAugment>
 struct RbTree {
+    using augment_type = typename Augment::type;
+
     enum RbColor {
         RED,
         BLACK
     };
 
     struct RbNode {
-        RbNode() noexcept
-            : left(nullptr),
-              right(nullptr),
-              parent(nullptr),
-              tree(nullptr),
-              color(RED) {}
+        RbNode() noexcept : left(nullptr), right(nullptr), parentColor(0) {}
 
         RbNode(RbNode &&) = delete;
 
         ~RbNode() noexcept {
-            if (tree) {
-                tree->doErase(this);
+            if constexpr (AutoUnlink) {
+                if (tree) {
+                    tree->doErase(this);
+                }
             }
         }
 
+        // 根结点恒为黑色，因此已在树中的结点 parentColor 必不为 0
+        bool is_linked() const noexcept {
+            return parentColor != 0;
+        }
+
         friend struct RbTree;
 
     private:
+        struct NoTree {};
+
         RbNode *left;
         RbNode *right;
-        RbNode *parent;
-        RbTree *tree;
-        RbColor color;
+        // 父结点指针，最低位存放颜色
+        std::uintptr_t parentColor;
+        [[no_unique_address]] std::conditional_t<AutoUnlink, RbTree *, NoTree>
+            tree{};
+        // 以该结点为根的子树的聚合值
+        [[no_unique_address]] augment_type augment{};
+
+        RbNode *parent() const noexcept {
+            return reinterpret_cast<RbNode *>(parentColor & ~std::uintptr_t(1));
+        }
+
+        void setParent(RbNode *node) noexcept {
+            parentColor = reinterpret_cast<std::uintptr_t>(node) |
+                          (parentColor & std::uintptr_t(1));
+        }
+
+        RbColor color() const noexcept {
+            return static_cast<RbColor>(parentColor & std::uintptr_t(1));
+        }
+
+        void setColor(RbColor color) noexcept {
+            parentColor = (parentColor & ~std::uintptr_t(1)) | color;
+        }
     };
 
+    static_assert(alignof(RbNode) >= 2, "low bit of RbNode * holds the color");
+
+    using Node = RbNode;
+
 private:
     RbNode *root;
+    // 缓存最左、最右结点，front()/back() 无需从根向下查找
+    RbNode *leftmost;
+    RbNode *rightmost;
     Compare comp;
 
+    static constexpr bool hasAugment = !std::is_same_v<Augment, RbNoAugment>;
+    static constexpr bool hasSize = requires(augment_type const &sum) {
+        { Augment::size(sum) } -> std::convertible_to<std::size_t>;
+    };
+
     bool compare(RbNode *left, RbNode *right) const noexcept {
         return comp(static_cast<Value &>(*left), static_cast<Value &>(*right));
     }
+
+    static augment_type getAugment(RbNode *node) noexcept {
+        return node != nullptr ? node->augment : Augment::identity();
+    }
+
+    static std::size_t getSize(RbNode *node) noexcept {
+        return node != nullptr ? Augment::size(node->augment) : 0;
+    }
+
+    // 由左右孩子重新计算结点的聚合值
+    static void pullAugment(RbNode *node) noexcept {
+        node->augment = Augment::combine(
+            Augment::combine(
+                getAugment(node->left),
+                Augment::value(static_cast<Value const &>(*node))),
+            getAugment(node->right));
+    }
+
+    // 从 node 开始向上更新到根
+    static void pullAugmentPath(RbNode *node) noexcept {
+        if constexpr (hasAugment) {
+            for (; node != nullptr; node = node->parent()) {
+                pullAugment(node);
+            }
+        }
+    }
     // 左旋
     void rotateLeft(RbNode *node) noexcept {
         RbNode *rightChild = node->right;
         node->right = rightChild->left;
         if (rightChild->left != nullptr) {
-            rightChild->left->parent = node;
+            rightChild->left->setParent(node);
         }
-        rightChild->parent = node->parent;
-        if (node->parent == nullptr) {
+        rightChild->setParent(node->parent());
+        if (node->parent() == nullptr) {
             root = rightChild;
-        } else if (node == node->parent->left) {
-            node->parent->left = rightChild;
+        } else if (node == node->parent()->left) {
+            node->parent()->left = rightChild;
         } else {
-            node->parent->right = rightChild;
+            node->parent()->right = rightChild;
         }
         rightChild->left = node;
-        node->parent = rightChild;
+        node->setParent(rightChild);
+        // 旋转只改变这两个结点的子树
+        if constexpr (hasAugment) {
+            pullAugment(node);
+            pullAugment(rightChild);
+        }
     }
     // 右旋
     void rotateRight(RbNode *node) noexcept {
         RbNode *leftChild = node->left;
         node->left = leftChild->right;
         if (leftChild->right != nullptr) {
-            leftChild->right->parent = node;
+            leftChild->right->setParent(node);
         }
-        leftChild->parent = node->parent;
-        if (node->parent == nullptr) {
+        leftChild->setParent(node->parent());
+        if (node->parent() == nullptr) {
             root = leftChild;
-        } else if (node == node->parent->right) {
-            node->parent->right = leftChild;
+        } else if (node == node->parent()->right) {
+            node->parent()->right = leftChild;
         } else {
-            node->parent->left = leftChild;
+            node->parent()->left = leftChild;
         }
         leftChild->right = node;
-        node->parent = leftChild;
+        node->setParent(leftChild);
+        if constexpr (hasAugment) {
+            pullAugment(node);
+            pullAugment(leftChild);
+        }
     }
-    // 平衡维护
-    void fixViolation(RbNode *node) noexcept {
+    // 平衡维护，返回根是否由红染黑（即整棵树黑高加一）
+    bool fixViolation(RbNode *node) noexcept {
         RbNode *parent = nullptr;
         RbNode *grandParent = nullptr;
 
-        while (node != root && node->color != BLACK &&
-               node->parent->color == RED) {
-            parent = node->parent;
-            grandParent = parent->parent;
+        while (node != root && node->color() != BLACK &&
+               node->parent()->color() == RED) {
+            parent = node->parent();
+            grandParent = parent->parent();
 
             if (parent == grandParent->left) {
                 RbNode *uncle = grandParent->right;
 
-                if (uncle != nullptr && uncle->color == RED) {
-                    grandParent->color = RED;
-                    parent->color = BLACK;
-                    uncle->color = BLACK;
+                if (uncle != nullptr && uncle->color() == RED) {
+                    grandParent->setColor(RED);
+                    parent->setColor(BLACK);
+                    uncle->setColor(BLACK);
                     node = grandParent;
                 } else {
                     if (node == parent->right) {
                         rotateLeft(parent);
                         node = parent;
-                        parent = node->parent;
+                        parent = node->parent();
                     }
                     rotateRight(grandParent);
-                    std::swap(parent->color, grandParent->color);
+                    RbColor color = parent->color();
+                    parent->setColor(grandParent->color());
+                    grandParent->setColor(color);
                     node = parent;
                 }
             } else {
                 RbNode *uncle = grandParent->left;
 
-                if (uncle != nullptr && uncle->color == RED) {
-                    grandParent->color = RED;
-                    parent->color = BLACK;
-                    uncle->color = BLACK;
+                if (uncle != nullptr && uncle->color() == RED) {
+                    grandParent->setColor(RED);
+                    parent->setColor(BLACK);
+                    uncle->setColor(BLACK);
                     node = grandParent;
                 } else {
                     if (node == parent->left) {
                         rotateRight(parent);
                         node = parent;
-                        parent = node->parent;
+                        parent = node->parent();
                     }
                     rotateLeft(grandParent);
-                    std::swap(parent->color, grandParent->color);
+                    RbColor color = parent->color();
+                    parent->setColor(grandParent->color());
+                    grandParent->setColor(color);
                     node = parent;
                 }
             }
         }
 
-        root->color = BLACK;
+        bool grown = root->color() == RED;
+        root->setColor(BLACK);
+        return grown;
     }
     // 添加结点
+    // 键相等时一律走向右侧，新结点排在所有等键结点之后
     void doInsert(RbNode *node) noexcept {
-        node->left = nullptr;
-        node->right = nullptr;
-        node->tree = this;
-        node->color = RED;
-
         RbNode *parent = nullptr;
         RbNode *current = root;
+        bool toLeft = false;
 
         while (current != nullptr) {
             parent = current;
-            if (compare(node, current)) {
-                current = current->left;
-            } else {
-                current = current->right;
-            }
+            toLeft = compare(node, current);
+            current = toLeft ? current->left : current->right;
         }
 
-        node->parent = parent;
+        doLink(node, parent, toLeft);
+    }
+
+    // 把结点挂到已定位的 parent 下并修复
+    void doLink(RbNode *node, RbNode *parent, bool toLeft) noexcept {
+        node->left = nullptr;
+        node->right = nullptr;
+        if constexpr (AutoUnlink) {
+            node->tree = this;
+        }
+        node->setColor(RED);
+        node->setParent(parent);
         if (parent == nullptr) {
             root = node;
-        } else if (compare(node, parent)) {
+            leftmost = node;
+            rightmost = node;
+        } else if (toLeft) {
             parent->left = node;
+            // 只有挂在最左结点左侧的新结点才会成为新的最左结点
+            if (parent == leftmost) {
+                leftmost = node;
+            }
         } else {
             parent->right = node;
+            if (parent == rightmost) {
+                rightmost = node;
+            }
         }
 
+        // 先沿插入路径更新聚合值，之后的旋转只需局部维护
+        pullAugmentPath(node);
         fixViolation(node);
     }
 
-    /* template <class Key> */
-    /* RbNode* doFind(Key &&key) const { */
-    /*     RbNode* current = root; */
-    /*     // Find the node to delete */
-    /*     while (current != nullptr) { */
-    /*         if (key_compare(key, current)) { */
-    /*             current = current->left; */
-    /*         } else { */
-    /*             current = current->right; */
-    /*         } */
-    /*     } */
-    /*     return nullptr; */
-    /* } */
-
-    /* void doErase(RbNode* node) noexcept { */
-    /*     RbNode* parent = nullptr; */
-    /*  */
-    /*     // Case 1: Node to delete has no children */
-    /*     if (node->left == nullptr && node->right == nullptr) { */
-    /*         if (node == root) { */
-    /*             root = nullptr; */
-    /*         } else { */
-    /*             if (node == parent->left) { */
-    /*                 parent->left = nullptr; */
-    /*             } else { */
-    /*                 parent->right = nullptr; */
-    /*             } */
-    /*         } */
-    /*         delete node; */
-    /*     } */
-    /*     // Case 2: Node to delete has one child */
-    /*     else if (node->left == nullptr || node->right == nullptr) { */
-    /*         RbNode* child = (node->left != nullptr) ? node->left : node->right; */
-    /*  */
-    /*         if (node == root) { */
-    /*             root = child; */
-    /*         } else { */
-    /*             if (node == parent->left) { */
-    /*                 parent->left = child; */
-    /*             } else { */
-    /*                 parent->right = child; */
-    /*             } */
-    /*         } */
-    /*         child->parent = parent; */
-    /*         delete node; */
-    /*     } */
-    /*     // Case 3: Node to delete has two children */
-    /*     else { */
-    /*         RbNode* successor = node->right; */
-    /*         while (successor->left != nullptr) { */
-    /*             successor = successor->left; */
-    /*         } */
-    /*         doErase(successor); */
-    /*     } */
-    /* } */
+    // 异构查找：Compare 声明了 is_transparent 时，可直接用任意可比较的键查找，
+    // 无需构造一个临时结点
+    template <class Key>
+    static constexpr bool isKeyComparable =
+        std::is_same_v<Key, Value> ||
+        requires { typename Compare::is_transparent; };
 
-    void doErase(RbNode *current) noexcept {
-        current->tree = nullptr;
+    // 第一个不小于 key 的结点
+    template <class Key>
+    RbNode *doLowerBound(Key const &key) const noexcept {
+        RbNode *current = root;
+        RbNode *result = nullptr;
+        while (current != nullptr) {
+            if (comp(static_cast<Value &>(*current), key)) {
+                current = current->right;
+            } else {
+                result = current;
+                current = current->left;
+            }
+        }
+        return result;
+    }
+
+    // 第一个大于 key 的结点
+    template <class Key>
+    RbNode *doUpperBound(Key const &key) const noexcept {
+        RbNode *current = root;
+        RbNode *result = nullptr;
+        while (current != nullptr) {
+            if (comp(key, static_cast<Value &>(*current))) {
+                result = current;
+                current = current->left;
+            } else {
+                current = current->right;
+            }
+        }
+        return result;
+    }
 
-        RbNode *node = nullptr;
-        RbNode *child = nullptr;
-        RbColor color = RED;
+    template <class Key>
+    RbNode *doFind(Key const &key) const noexcept {
+        RbNode *node = doLowerBound(key);
+        if (node != nullptr && comp(key, static_cast<Value &>(*node))) {
+            return nullptr;
+        }
+        return node;
+    }
+
+    static bool isBlack(RbNode *node) noexcept {
+        return node == nullptr || node->color() == BLACK;
+    }
 
-        if (current->left != nullptr && current->right != nullptr) {
-            RbNode *replace = current;
-            replace = replace->right;
-            while (replace->left != nullptr) {
-                replace = replace->left;
+    // 在 parent 中用 replacement 替换孩子 node，parent 为空时替换根
+    void replaceChild(RbNode *parent, RbNode *node, RbNode *replacement) noexcept {
+        if (parent == nullptr) {
+            root = replacement;
+        } else if (parent->left == node) {
+            parent->left = replacement;
+        } else {
+            parent->right = replacement;
+        }
+    }
+
+    // 删除后的平衡维护：node 所在路径少了一个黑结点
+    // node 可能为空，因此单独传入其父结点
+    void fixEraseViolation(RbNode *node, RbNode *parent) noexcept {
+        while (node != root && isBlack(node)) {
+            if (node == parent->left) {
+                RbNode *sibling = parent->right;
+                if (sibling->color() == RED) {
+                    sibling->setColor(BLACK);
+                    parent->setColor(RED);
+                    rotateLeft(parent);
+                    sibling = parent->right;
+                }
+                if (isBlack(sibling->left) && isBlack(sibling->right)) {
+                    sibling->setColor(RED);
+                    node = parent;
+                    parent = node->parent();
+                } else {
+                    if (isBlack(sibling->right)) {
+                        sibling->left->setColor(BLACK);
+                        sibling->setColor(RED);
+                        rotateRight(sibling);
+                        sibling = parent->right;
+                    }
+                    sibling->setColor(parent->color());
+                    parent->setColor(BLACK);
+                    sibling->right->setColor(BLACK);
+                    rotateLeft(parent);
+                    node = root;
+                }
+            } else {
+                RbNode *sibling = parent->left;
+                if (sibling->color() == RED) {
+                    sibling->setColor(BLACK);
+                    parent->setColor(RED);
+                    rotateRight(parent);
+                    sibling = parent->left;
+                }
+                if (isBlack(sibling->left) && isBlack(sibling->right)) {
+                    sibling->setColor(RED);
+                    node = parent;
+                    parent = node->parent();
+                } else {
+                    if (isBlack(sibling->left)) {
+                        sibling->right->setColor(BLACK);
+                        sibling->setColor(RED);
+                        rotateLeft(sibling);
+                        sibling = parent->left;
+                    }
+                    sibling->setColor(parent->color());
+                    parent->setColor(BLACK);
+                    sibling->left->setColor(BLACK);
+                    rotateRight(parent);
+                    node = root;
+                }
             }
+        }
+        if (node != nullptr) {
+            node->setColor(BLACK);
+        }
+    }
+
+    // 删除结点
+    // 有两个孩子时由中序后继顶替其位置与颜色，中序顺序不变
+    void doErase(RbNode *current) noexcept {
+        // 在结构调整前更新缓存的最左、最右结点
+        if (current == leftmost) {
+            leftmost = getNext(current);
+        }
+        if (current == rightmost) {
+            rightmost = getPrev(current);
+        }
 
-            if (current != replace->parent) {
-                current->parent->left = replace->right;
-                replace->right = current->right;
-                current->right->parent = replace;
+        // child 顶替了实际被移走的位置，parent 为其父结点，color 为移走的颜色
+        RbNode *child;
+        RbNode *parent;
+        RbColor color;
+
+        if (current->left == nullptr || current->right == nullptr) {
+            child = current->left != nullptr ? current->left : current->right;
+            parent = current->parent();
+            color = current->color();
+            replaceChild(parent, current, child);
+            if (child != nullptr) {
+                child->setParent(parent);
+            }
+        } else {
+            RbNode *successor = getMin(current->right);
+            child = successor->right;
+            color = successor->color();
+            if (successor->parent() == current) {
+                parent = successor;
             } else {
-                replace->parent = current;
+                parent = successor->parent();
+                parent->left = child;
+                if (child != nullptr) {
+                    child->setParent(parent);
+                }
+                successor->right = current->right;
+                current->right->setParent(successor);
             }
+            successor->left = current->left;
+            current->left->setParent(successor);
+            replaceChild(current->parent(), current, successor);
+            // 继承父指针与颜色
+            successor->parentColor = current->parentColor;
+        }
+
+        // 被移走位置以上的聚合值需要重新计算
+        pullAugmentPath(parent);
+
+        if (color == BLACK) {
+            fixEraseViolation(child, parent);
+        }
+
+        resetNode(current);
+    }
+
+    // 清空结点的链接，is_linked() 据此判断
+    static void resetNode(RbNode *node) noexcept {
+        node->left = nullptr;
+        node->right = nullptr;
+        node->parentColor = 0;
+        if constexpr (AutoUnlink) {
+            node->tree = nullptr;
+        }
+    }
 
-            if (current == root) {
-                root = replace;
-            } else if (current->parent->left == current) {
-                current->parent->left = replace;
+    // 后序逐个摘除叶子，O(n) 且不需要栈
+    // 摘下的结点随即交给 dispose，之后不再访问
+    template <class Disposer>
+    void doClear(Disposer &&dispose) noexcept {
+        RbNode *node = root;
+        while (node != nullptr) {
+            if (node->left != nullptr) {
+                node = node->left;
+            } else if (node->right != nullptr) {
+                node = node->right;
             } else {
-                current->parent->right = replace;
+                RbNode *parent = node->parent();
+                if (parent != nullptr) {
+                    if (parent->left == node) {
+                        parent->left = nullptr;
+                    } else {
+                        parent->right = nullptr;
+                    }
+                }
+                resetNode(node);
+                dispose(static_cast<Value &>(*node));
+                node = parent;
             }
+        }
+        root = nullptr;
+        leftmost = nullptr;
+        rightmost = nullptr;
+    }
 
-            replace->left = current->left;
-            current->left->parent = replace;
+    void doClear() noexcept {
+        doClear([](Value &) noexcept {});
+    }
 
-            node = replace;
-            color = node->color;
-            child = node->right;
-        } else {
-            node = current;
-            color = node->color;
-            child = (node->left != nullptr) ? node->left : node->right;
+    // 取中点为根递归建树，深度为 redDepth 的结点（最底层未满的一层）染红，
+    // 其余染黑，各路径黑高相同
+    template <class It>
+    RbNode *doBuild(It first,
+                    std::size_t count,
+                    std::size_t depth,
+                    std::size_t redDepth,
+                    RbNode *parent) noexcept {
+        if (count == 0) {
+            return nullptr;
+        }
+        std::size_t mid = count / 2;
+        RbNode *node = &static_cast<RbNode &>(static_cast<Value &>(first[mid]));
+        node->parentColor = 0;
+        node->setParent(parent);
+        node->setColor(depth == redDepth ? RED : BLACK);
+        if constexpr (AutoUnlink) {
+            node->tree = this;
         }
+        node->left = doBuild(first, mid, depth + 1, redDepth, node);
+        node->right =
+            doBuild(first + (mid + 1), count - mid - 1, depth + 1, redDepth, node);
+        if constexpr (hasAugment) {
+            pullAugment(node);
+        }
+        return node;
+    }
 
-        if (child != nullptr) {
-            child->parent = node->parent;
+    // 中序后继
+    static RbNode *getNext(RbNode *node) noexcept {
+        if (node->right != nullptr) {
+            node = node->right;
+            while (node->left != nullptr) {
+                node = node->left;
+            }
+            return node;
+        }
+        RbNode *parent = node->parent();
+        while (parent != nullptr && node == parent->right) {
+            node = parent;
+            parent = parent->parent();
         }
+        return parent;
+    }
 
-        if (node == root) {
-            root = child;
-        } else if (node->parent->left == node) {
-            node->parent->left = child;
-        } else {
-            node->parent->right = child;
+    // 中序前驱
+    static RbNode *getPrev(RbNode *node) noexcept {
+        if (node->left != nullptr) {
+            node = node->left;
+            while (node->right != nullptr) {
+                node = node->right;
+            }
+            return node;
         }
+        RbNode *parent = node->parent();
+        while (parent != nullptr && node == parent->left) {
+            node = parent;
+            parent = parent->parent();
+        }
+        return parent;
+    }
 
-        if (color == BLACK && root) {
-            fixViolation(child ? child : node->parent);
+    static RbNode *getMin(RbNode *node) noexcept {
+        while (node->left != nullptr) {
+            node = node->left;
         }
+        return node;
     }
 
-    RbNode *getFront() const noexcept {
-        RbNode *current = root;
-        while (current->left != nullptr) {
-            current = current->left;
+    static RbNode *getMax(RbNode *node) noexcept {
+        while (node->right != nullptr) {
+            node = node->right;
         }
-        return current;
+        return node;
     }
 
-    RbNode *getBack() const noexcept {
-        RbNode *current = root;
-        while (current->right != nullptr) {
-            current = current->right;
+    // 黑高：从 node 到空结点路径上的黑结点数（含 node），O(log n)
+    static std::size_t blackHeight(RbNode *node) noexcept {
+        std::size_t height = 0;
+        for (; node != nullptr; node = node->left) {
+            height += node->color() == BLACK;
         }
-        return current;
+        return height;
     }
 
-    template <class Visitor>
-    void doTraversalInorder(RbNode *node, Visitor &&visitor) {
+    // 独立的一棵子树及其黑高，split/join 过程中传递
+    struct SubTree {
+        RbNode *root;
+        std::size_t height;
+    };
+
+    // 把孩子摘成一棵独立的树，红根染黑后黑高加一
+    static SubTree detachChild(RbNode *node, std::size_t height) noexcept {
         if (node == nullptr) {
-            return;
+            return {nullptr, 0};
+        }
+        node->setParent(nullptr);
+        if (node->color() == RED) {
+            node->setColor(BLACK);
+            ++height;
+        }
+        return {node, height};
+    }
+
+    // 以 middle 为中间结点连接 left < middle <= right 两棵树
+    // 沿较高一棵的边缘下降到黑高相同处挂上 middle，再做插入平衡
+    // 代价为 O(两树黑高之差 + 1)，root 用作工作区
+    SubTree doJoin(SubTree left, RbNode *middle, SubTree right) noexcept {
+        middle->parentColor = 0;
+        RbNode *parent = nullptr;
+        std::size_t height;
+
+        if (left.height >= right.height) {
+            root = left.root;
+            RbNode *node = left.root;
+            std::size_t h = left.height;
+            while (node != nullptr &&
+                   (h > right.height || node->color() == RED)) {
+                h -= node->color() == BLACK;
+                parent = node;
+                node = node->right;
+            }
+            middle->left = node;
+            middle->right = right.root;
+            if (parent != nullptr) {
+                parent->right = middle;
+            }
+            height = left.height;
+        } else {
+            root = right.root;
+            RbNode *node = right.root;
+            std::size_t h = right.height;
+            while (node != nullptr &&
+                   (h > left.height || node->color() == RED)) {
+                h -= node->color() == BLACK;
+                parent = node;
+                node = node->left;
+            }
+            middle->left = left.root;
+            middle->right = node;
+            if (parent != nullptr) {
+                parent->left = middle;
+            }
+            height = right.height;
+        }
+
+        middle->setParent(parent);
+        middle->setColor(RED);
+        if (middle->left != nullptr) {
+            middle->left->setParent(middle);
+        }
+        if (middle->right != nullptr) {
+            middle->right->setParent(middle);
+        }
+        if (parent == nullptr) {
+            root = middle;
         }
 
-        traversalInorder(node->left, visitor);
-        visitor(node);
-        doTraversalInorder(node->right, visitor);
+        pullAugmentPath(middle);
+        if (fixViolation(middle)) {
+            ++height;
+        }
+        return {root, height};
+    }
+
+    // 把 tree 拆成小于 key 与不小于 key 的两棵树
+    // 沿查找路径自顶向下，每层与一侧已拆出的子树 join，黑高逐层递减，
+    // 总代价 O(log n)
+    template <class Key>
+    std::pair<SubTree, SubTree> doSplit(SubTree tree, Key const &key) noexcept {
+        RbNode *node = tree.root;
+        if (node == nullptr) {
+            return {{nullptr, 0}, {nullptr, 0}};
+        }
+        std::size_t height = tree.height - (node->color() == BLACK);
+        SubTree left = detachChild(node->left, height);
+        SubTree right = detachChild(node->right, height);
+
+        if (comp(static_cast<Value &>(*node), key)) {
+            auto [lower, upper] = doSplit(right, key);
+            return {doJoin(left, node, lower), upper};
+        } else {
+            auto [lower, upper] = doSplit(left, key);
+            return {lower, doJoin(upper, node, right)};
+        }
+    }
+
+    // 从 tree 中拆出最小结点，返回该结点与剩余部分，O(log n)
+    std::pair<RbNode *, SubTree> doSplitFirst(SubTree tree) noexcept {
+        RbNode *node = tree.root;
+        std::size_t height = tree.height - (node->color() == BLACK);
+        SubTree right = detachChild(node->right, height);
+        if (node->left == nullptr) {
+            return {node, right};
+        }
+        SubTree left = detachChild(node->left, height);
+        auto [first, rest] = doSplitFirst(left);
+        return {first, doJoin(rest, node, right)};
+    }
+
+    // 让子树中每个结点指向新的所属树，O(k)
+    static void relinkTree(RbNode *node, RbTree *tree) noexcept {
+        if constexpr (AutoUnlink) {
+            if (node != nullptr) {
+                for (node = getMin(node); node != nullptr;
+                     node = getNext(node)) {
+                    node->tree = tree;
+                }
+            }
+        }
+    }
+
+    // 递归检查以 node 为根的子树，返回其黑高（不含空结点）
+    // 发现问题时把描述写入 error 并尽早返回；depth 为 node 的深度，从 1 开始
+    std::size_t doValidate(RbNode *node, RbNode *parent, std::size_t depth,
+                           std::size_t &height,
+                           char const *&error) const noexcept {
+        if (node == nullptr || error != nullptr) {
+            return 0;
+        }
+        if (depth > height) {
+            height = depth;
+        }
+        if (node->parent() != parent) {
+            error = "parent link mismatch";
+            return 0;
+        }
+        if constexpr (AutoUnlink) {
+            if (node->tree != this) {
+                error = "node points to another tree";
+                return 0;
+            }
+        }
+        if (node->color() == RED && (!isBlack(node->left) ||
+                                     !isBlack(node->right))) {
+            error = "red node has a red child";
+            return 0;
+        }
+        if constexpr (hasSize) {
+            if (getSize(node) != getSize(node->left) + getSize(node->right) + 1) {
+                error = "subtree size mismatch";
+                return 0;
+            }
+        } else if constexpr (hasAugment &&
+                             std::equality_comparable<augment_type>) {
+            augment_type expected = Augment::combine(
+                Augment::combine(
+                    getAugment(node->left),
+                    Augment::value(static_cast<Value const &>(*node))),
+                getAugment(node->right));
+            if (!(node->augment == expected)) {
+                error = "augment mismatch";
+                return 0;
+            }
+        }
+        std::size_t left =
+            doValidate(node->left, node, depth + 1, height, error);
+        std::size_t right =
+            doValidate(node->right, node, depth + 1, height, error);
+        if (error == nullptr && left != right) {
+            error = "black height mismatch";
+        }
+        return left + (node->color() == BLACK);
+    }
+
+    RbNode *getFront() const noexcept {
+        return leftmost;
+    }
+
+    RbNode *getBack() const noexcept {
+        return rightmost;
     }
 
 public:
-    RbTree() noexcept : root(nullptr) {}
+    // 双向迭代器，沿父指针移动，无需栈也不分配内存
+    // 自增、自减均摊 O(1)，end() 对应空结点
+    struct iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        iterator() noexcept : node(nullptr), tree(nullptr) {}
+
+        Value &operator*() const noexcept {
+            return static_cast<Value &>(*node);
+        }
+
+        Value *operator->() const noexcept {
+            return static_cast<Value *>(node);
+        }
+
+        iterator &operator++() noexcept {
+            node = getNext(node);
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        // end() 自减得到最右结点
+        iterator &operator--() noexcept {
+            node = node != nullptr ? getPrev(node) : tree->rightmost;
+            return *this;
+        }
+
+        iterator operator--(int) noexcept {
+            iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(iterator const &lhs,
+                               iterator const &rhs) noexcept {
+            return lhs.node == rhs.node;
+        }
+
+        friend struct RbTree;
+
+    private:
+        iterator(RbNode *node, RbTree const *tree) noexcept
+            : node(node),
+              tree(tree) {}
+
+        RbNode *node;
+        RbTree const *tree;
+    };
+
+    RbTree() noexcept
+        : root(nullptr),
+          leftmost(nullptr),
+          rightmost(nullptr) {}
 
     explicit RbTree(Compare comp) noexcept(noexcept(Compare(comp)))
         : root(nullptr),
+          leftmost(nullptr),
+          rightmost(nullptr),
           comp(comp) {}
 
     RbTree(RbTree &&) = delete;
@@ -322,6 +902,45 @@ public:
         doErase(&static_cast<RbNode &>(value));
     }
 
+    // 唯一键插入分两步：insert_check 只查找，键已存在时返回该元素和 false；
+    // 否则记下插入位置，随后 insert_commit 直接挂入，中间不得修改树
+    // 用于键不存在时才构造元素的场合，整个过程只下降一次
+    struct insert_commit_data {
+        RbNode *parent;
+        bool toLeft;
+    };
+
+    template <class Key>
+        requires isKeyComparable<Key>
+    std::pair<iterator, bool>
+    insert_check(Key const &key, insert_commit_data &data) const noexcept {
+        RbNode *parent = nullptr;
+        RbNode *current = root;
+        // 最后一个不大于 key 的结点
+        RbNode *candidate = nullptr;
+        bool toLeft = false;
+        while (current != nullptr) {
+            parent = current;
+            toLeft = comp(key, static_cast<Value &>(*current));
+            if (toLeft) {
+                current = current->left;
+            } else {
+                candidate = current;
+                current = current->right;
+            }
+        }
+        if (candidate != nullptr &&
+            !comp(static_cast<Value &>(*candidate), key)) {
+            return {iterator(candidate, this), false};
+        }
+        data = {parent, toLeft};
+        return {end(), true};
+    }
+
+    void insert_commit(Value &value, insert_commit_data const &data) noexcept {
+        doLink(&static_cast<RbNode &>(value), data.parent, data.toLeft);
+    }
+
     bool empty() const noexcept {
         return root == nullptr;
     }
@@ -334,8 +953,347 @@ public:
         return static_cast<Value &>(*getBack());
     }
 
+    // 摘除所有结点，O(n)
+    void clear() noexcept {
+        doClear();
+    }
+
+    // 摘除所有结点并逐个交给 dispose（如释放结点），O(n)
+    // 调用 dispose 时该结点已不在树中，树的其余部分也不再经由它访问
+    template <class Disposer>
+    void clear_and_dispose(Disposer &&dispose) noexcept {
+        doClear(dispose);
+    }
+
+    // 用已按 Compare 排好序的元素替换树中内容，O(n) 建出平衡的红黑树
+    // 键相等的元素保持输入中的先后顺序
+    template <std::ranges::random_access_range Range>
+        requires std::ranges::sized_range<Range> &&
+                 std::convertible_to<std::ranges::range_reference_t<Range>,
+                                     Value &>
+    void assign_sorted(Range &&range) noexcept {
+        doClear();
+        std::size_t count = std::ranges::size(range);
+        if (count == 0) {
+            return;
+        }
+        auto first = std::ranges::begin(range);
+        std::size_t redDepth = std::bit_width(count + 1) - 1;
+        root = doBuild(first, count, 0, redDepth, nullptr);
+        leftmost = &static_cast<RbNode &>(static_cast<Value &>(first[0]));
+        rightmost =
+            &static_cast<RbNode &>(static_cast<Value &>(first[count - 1]));
+    }
+
+    // 把不小于 key 的元素移入 right，其余移入 left，O(log n)
+    // left、right 须为空树或 *this 本身，且互不相同；*this 不是二者之一时被清空
+    // AutoUnlink 时移到其他树的结点需逐个改写树指针，为 O(移动的结点数)
+    template <class Key>
+        requires isKeyComparable<Key>
+    void split(Key const &key, RbTree &left, RbTree &right) noexcept {
+        RbNode *first = leftmost;
+        RbNode *last = rightmost;
+        SubTree whole{root, blackHeight(root)};
+        root = nullptr;
+        leftmost = nullptr;
+        rightmost = nullptr;
+
+        auto [lower, upper] = doSplit(whole, key);
+        root = nullptr;
+
+        left.root = lower.root;
+        left.leftmost = lower.root != nullptr ? first : nullptr;
+        left.rightmost = lower.root != nullptr ? getMax(lower.root) : nullptr;
+        right.root = upper.root;
+        right.leftmost = upper.root != nullptr ? getMin(upper.root) : nullptr;
+        right.rightmost = upper.root != nullptr ? last : nullptr;
+
+        if (&left != this) {
+            relinkTree(left.root, &left);
+        }
+        if (&right != this) {
+            relinkTree(right.root, &right);
+        }
+    }
+
+    // 把 left 与 right 的全部元素按先后拼接到 *this，O(log n)
+    // left 中的元素均不得大于 right 中的元素
+    // *this 须为空树或 left、right 之一；其余参与的树被清空
+    // AutoUnlink 时移入的结点需逐个改写树指针，为 O(移动的结点数)
+    void join(RbTree &left, RbTree &right) noexcept {
+        RbNode *leftRoot = left.root;
+        RbNode *leftFirst = left.leftmost;
+        RbNode *rightRoot = right.root;
+        RbNode *rightFirst = right.leftmost;
+        RbNode *rightLast = right.rightmost;
+        RbNode *leftLast = left.rightmost;
+
+        left.root = left.leftmost = left.rightmost = nullptr;
+        right.root = right.leftmost = right.rightmost = nullptr;
+
+        if (&left != this) {
+            relinkTree(leftRoot, this);
+        }
+        if (&right != this) {
+            relinkTree(rightRoot, this);
+        }
+
+        if (leftRoot == nullptr) {
+            root = rightRoot;
+            leftmost = rightFirst;
+            rightmost = rightLast;
+        } else if (rightRoot == nullptr) {
+            root = leftRoot;
+            leftmost = leftFirst;
+            rightmost = leftLast;
+        } else {
+            // 拆出右树的最小结点作为连接用的中间结点
+            auto [middle, rest] =
+                doSplitFirst({rightRoot, blackHeight(rightRoot)});
+            doJoin({leftRoot, blackHeight(leftRoot)}, middle, rest);
+            leftmost = leftFirst;
+            rightmost = rightLast;
+        }
+    }
+
+    // 取出并删除最小结点，树不能为空
+    Value &pop_front() noexcept {
+        RbNode *node = getFront();
+        doErase(node);
+        return static_cast<Value &>(*node);
+    }
+
+    iterator begin() const noexcept {
+        return iterator(leftmost, this);
+    }
+
+    iterator end() const noexcept {
+        return iterator(nullptr, this);
+    }
+
+    // 由已在树中的元素得到其迭代器
+    iterator iterator_to(Value &value) const noexcept {
+        return iterator(&static_cast<RbNode &>(value), this);
+    }
+
+    // 查找接口均返回 end() 表示不存在
+    // 键相等的结点有多个时，find 返回其中最先插入的一个
+    template <class Key>
+        requires isKeyComparable<Key>
+    iterator find(Key const &key) const noexcept {
+        return iterator(doFind(key), this);
+    }
+
+    template <class Key>
+        requires isKeyComparable<Key>
+    iterator lower_bound(Key const &key) const noexcept {
+        return iterator(doLowerBound(key), this);
+    }
+
+    template <class Key>
+        requires isKeyComparable<Key>
+    iterator upper_bound(Key const &key) const noexcept {
+        return iterator(doUpperBound(key), this);
+    }
+
+    // 返回键等于 key 的左闭右开区间 [first, last)
+    template <class Key>
+        requires isKeyComparable<Key>
+    std::pair<iterator, iterator> equal_range(Key const &key) const noexcept {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    // 以下接口需要增强策略提供 size，即子树大小
+    std::size_t size() const noexcept
+        requires hasSize
+    {
+        return getSize(root);
+    }
+
+    // 元素在中序中的位置（从 0 开始），O(log n)
+    std::size_t rank(Value const &value) const noexcept
+        requires hasSize
+    {
+        RbNode *node = const_cast<RbNode *>(&static_cast<RbNode const &>(value));
+        std::size_t result = getSize(node->left);
+        for (RbNode *parent = node->parent(); parent != nullptr;
+             node = parent, parent = parent->parent()) {
+            if (node == parent->right) {
+                result += getSize(parent->left) + 1;
+            }
+        }
+        return result;
+    }
+
+    // 中序第 k 个元素（从 0 开始），越界返回 end()，O(log n)
+    iterator select(std::size_t k) const noexcept
+        requires hasSize
+    {
+        RbNode *current = root;
+        while (current != nullptr) {
+            std::size_t leftSize = getSize(current->left);
+            if (k < leftSize) {
+                current = current->left;
+            } else if (k == leftSize) {
+                break;
+            } else {
+                k -= leftSize + 1;
+                current = current->right;
+            }
+        }
+        return iterator(current, this);
+    }
+
+    // 整棵树的聚合值
+    augment_type aggregate() const noexcept
+        requires hasAugment
+    {
+        return getAugment(root);
+    }
+
+    // 键在 [lo, hi) 内的元素按中序合并的聚合值，O(log n)
+    template <class Key>
+        requires hasAugment && isKeyComparable<Key>
+    augment_type aggregate(Key const &lo, Key const &hi) const noexcept {
+        // 找到第一个落在区间内的分叉结点
+        RbNode *split = root;
+        while (split != nullptr) {
+            Value const &value = static_cast<Value &>(*split);
+            if (comp(value, lo)) {
+                split = split->right;
+            } else if (!comp(value, hi)) {
+                split = split->left;
+            } else {
+                break;
+            }
+        }
+        if (split == nullptr) {
+            return Augment::identity();
+        }
+
+        // 左子树中不小于 lo 的部分，越往下越靠左，故向前合并
+        augment_type leftSum = Augment::identity();
+        for (RbNode *node = split->left; node != nullptr;) {
+            if (comp(static_cast<Value &>(*node), lo)) {
+                node = node->right;
+            } else {
+                leftSum = Augment::combine(
+                    Augment::combine(
+                        Augment::value(static_cast<Value const &>(*node)),
+                        getAugment(node->right)),
+                    leftSum);
+                node = node->left;
+            }
+        }
+
+        // 右子树中小于 hi 的部分，越往下越靠右，故向后合并
+        augment_type rightSum = Augment::identity();
+        for (RbNode *node = split->right; node != nullptr;) {
+            if (comp(static_cast<Value &>(*node), hi)) {
+                rightSum = Augment::combine(
+                    rightSum,
+                    Augment::combine(
+                        getAugment(node->left),
+                        Augment::value(static_cast<Value const &>(*node))));
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+
+        return Augment::combine(
+            Augment::combine(
+                leftSum, Augment::value(static_cast<Value const &>(*split))),
+            rightSum);
+    }
+
+    // 区间树模式（Augment 为 RbIntervalAugment）：按 start 顺序访问所有与
+    // [lo, hi) 相交的元素，即 start < hi 且 end > lo
+    // 子树最大 end 不超过 lo 时整棵跳过，遇到 start 不小于 hi 的结点即停止，
+    // 代价 O((k + 1) log n)，k 为命中数，不分配内存；visitor 中不得修改树
+    template <class Visitor>
+        requires requires { Augment::isInterval; } &&
+                 isKeyComparable<augment_type>
+    void for_each_overlapping(augment_type const &lo, augment_type const &hi,
+                              Visitor &&visitor) const {
+        // 红黑树高不超过 2 log2(n + 1)
+        RbNode *stack[2 * std::numeric_limits<std::size_t>::digits];
+        std::size_t depth = 0;
+        RbNode *node = root;
+        while (true) {
+            while (node != nullptr && lo < node->augment) {
+                stack[depth++] = node;
+                node = node->left;
+            }
+            if (depth == 0) {
+                break;
+            }
+            node = stack[--depth];
+            Value &value = static_cast<Value &>(*node);
+            if (!comp(value, hi)) {
+                break;
+            }
+            if (lo < Augment::value(static_cast<Value const &>(value))) {
+                visitor(value);
+            }
+            node = node->right;
+        }
+    }
+
+    // validate() 的结果，error 为空表示所有约束均成立
+    struct validate_result {
+        char const *error;
+        std::size_t size;
+        // 最长的根到叶路径上的结点数，红黑树保证不超过 2 log2(size + 1)
+        std::size_t height;
+        std::size_t blackHeight;
+
+        explicit operator bool() const noexcept {
+            return error == nullptr;
+        }
+    };
+
+    // 检查红黑树的全部约束，O(n)，用于测试与排查：
+    // 根为黑、父指针一致、无连续红结点、各路径黑高相同、中序非降、
+    // 最左最右缓存正确、AutoUnlink 的树指针与增强值正确
+    validate_result validate() const noexcept {
+        validate_result result{nullptr, 0, 0, 0};
+        if (root == nullptr) {
+            if (leftmost != nullptr || rightmost != nullptr) {
+                result.error = "empty tree caches leftmost/rightmost";
+            }
+            return result;
+        }
+        if (root->color() != BLACK) {
+            result.error = "root is red";
+            return result;
+        }
+        result.blackHeight =
+            doValidate(root, nullptr, 1, result.height, result.error);
+        if (result.error != nullptr) {
+            return result;
+        }
+        if (leftmost != getMin(root) || rightmost != getMax(root)) {
+            result.error = "leftmost/rightmost cache mismatch";
+            return result;
+        }
+        RbNode *prev = nullptr;
+        for (RbNode *node = leftmost; node != nullptr; node = getNext(node)) {
+            if (prev != nullptr && compare(node, prev)) {
+                result.error = "inorder sequence not sorted";
+                return result;
+            }
+            prev = node;
+            ++result.size;
+        }
+        return result;
+    }
+
+    // 非递归中序遍历，visitor 接收 Value &
     template <class Visitor>
     void traversalInorder(Visitor &&visitor) {
-        doTraversalInorder(root, std::forward<Visitor>(visitor));
+        for (RbNode *node = leftmost; node != nullptr; node = getNext(node)) {
+            visitor(static_cast<Value &>(*node));
+        }
     }
 };
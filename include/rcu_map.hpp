@@ -0,0 +1,339 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 读多写少的并发有序表
+// 读者在不可变的快照上无锁查找；写者（互斥）按路径复制修改过的结点，
+// 以原子操作发布新根，旧结点按纪元（epoch）延迟回收
+// 侵入式 RbTree 依赖父指针原地修改，无法做路径复制，这里的快照树用 AVL 平衡
+template <class Key, class Value, class Compare = std::less<Key>>
+struct RcuMap {
+private:
+    struct Node {
+        Key key;
+        Value value;
+        Node const *left;
+        Node const *right;
+        int height;
+    };
+
+    // 每个读者占用一个槽位，记录进入时的纪元，0 表示空闲
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> epoch{0};
+    };
+
+    static constexpr std::size_t kMaxReaders = 64;
+
+    std::atomic<Node const *> root{nullptr};
+    std::atomic<std::uint64_t> globalEpoch{1};
+    std::atomic<std::size_t> count{0};
+    mutable std::array<ReaderSlot, kMaxReaders> slots;
+
+    // 以下仅在持有 writeMutex 时访问
+    std::mutex writeMutex;
+    std::vector<std::pair<std::uint64_t, Node const *>> retired;
+    std::vector<Node const *> pending;
+    Compare comp;
+
+    static int height(Node const *node) noexcept {
+        return node != nullptr ? node->height : 0;
+    }
+
+    static Node const *
+    makeNode(Key const &key, Value const &value, Node const *left, Node const *right) {
+        int h = height(left) > height(right) ? height(left) : height(right);
+        return new Node{key, value, left, right, h + 1};
+    }
+
+    // 本次写操作中被替换的结点，发布新根后统一退休
+    void retire(Node const *node) {
+        pending.push_back(node);
+    }
+
+    // 以 from 的键值和新的左右孩子重建结点，from 被替换
+    Node const *rebuild(Node const *from, Node const *left, Node const *right) {
+        retire(from);
+        return makeNode(from->key, from->value, left, right);
+    }
+
+    // 重建结点并在左右高度差超过 1 时旋转，旋转涉及的结点同样复制
+    Node const *balance(Node const *from, Node const *left, Node const *right) {
+        if (height(left) > height(right) + 1) {
+            if (height(left->left) >= height(left->right)) {
+                return rebuild(left, left->left, rebuild(from, left->right, right));
+            }
+            Node const *middle = left->right;
+            return rebuild(middle, rebuild(left, left->left, middle->left),
+                           rebuild(from, middle->right, right));
+        }
+        if (height(right) > height(left) + 1) {
+            if (height(right->right) >= height(right->left)) {
+                return rebuild(right, rebuild(from, left, right->left), right->right);
+            }
+            Node const *middle = right->left;
+            return rebuild(middle, rebuild(from, left, middle->left),
+                           rebuild(right, middle->right, right->right));
+        }
+        return rebuild(from, left, right);
+    }
+
+    Node const *doInsert(Node const *node, Key const &key, Value const &value,
+                         bool &inserted) {
+        if (node == nullptr) {
+            inserted = true;
+            return makeNode(key, value, nullptr, nullptr);
+        }
+        if (comp(key, node->key)) {
+            return balance(node, doInsert(node->left, key, value, inserted),
+                           node->right);
+        }
+        if (comp(node->key, key)) {
+            return balance(node, node->left,
+                           doInsert(node->right, key, value, inserted));
+        }
+        retire(node);
+        return makeNode(node->key, value, node->left, node->right);
+    }
+
+    // 摘下最小结点交给 first，first 本身不退休，由调用者处理
+    Node const *doEraseMin(Node const *node, Node const *&first) {
+        if (node->left == nullptr) {
+            first = node;
+            return node->right;
+        }
+        return balance(node, doEraseMin(node->left, first), node->right);
+    }
+
+    template <class K>
+    Node const *doErase(Node const *node, K const &key, bool &erased) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        if (comp(key, node->key)) {
+            Node const *left = doErase(node->left, key, erased);
+            return erased ? balance(node, left, node->right) : node;
+        }
+        if (comp(node->key, key)) {
+            Node const *right = doErase(node->right, key, erased);
+            return erased ? balance(node, node->left, right) : node;
+        }
+        erased = true;
+        retire(node);
+        if (node->left == nullptr) {
+            return node->right;
+        }
+        if (node->right == nullptr) {
+            return node->left;
+        }
+        // 由右子树的最小结点顶替
+        Node const *first = nullptr;
+        Node const *right = doEraseMin(node->right, first);
+        return balance(first, node->left, right);
+    }
+
+    // 发布新根：旧根之后进入的读者只能看到新树，
+    // 本次替换下来的结点标记为当前纪元，纪元随后加一
+    void publish(Node const *newRoot) {
+        root.store(newRoot, std::memory_order_seq_cst);
+        std::uint64_t epoch =
+            globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+        for (Node const *node: pending) {
+            retired.emplace_back(epoch, node);
+        }
+        pending.clear();
+        reclaim();
+    }
+
+    // 回收所有活跃读者都不可能再看到的结点
+    void reclaim() {
+        std::uint64_t oldest = globalEpoch.load(std::memory_order_seq_cst);
+        for (auto const &slot: slots) {
+            std::uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0 && epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+        std::size_t kept = 0;
+        for (auto const &entry: retired) {
+            if (entry.first < oldest) {
+                delete entry.second;
+            } else {
+                retired[kept++] = entry;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    static void destroyTree(Node const *node) noexcept {
+        while (node != nullptr) {
+            destroyTree(node->left);
+            Node const *right = node->right;
+            delete node;
+            node = right;
+        }
+    }
+
+    // 每个线程优先使用固定的槽位，冲突时向后探测
+    static std::size_t slotHint() noexcept {
+        static std::atomic<std::size_t> nextHint{0};
+        thread_local std::size_t hint =
+            nextHint.fetch_add(1, std::memory_order_relaxed) % kMaxReaders;
+        return hint;
+    }
+
+public:
+    // 读快照：存续期间看到的树不会被修改或回收
+    // 持有时间应尽量短，否则会推迟旧结点的回收
+    struct ReadGuard {
+        ReadGuard(ReadGuard &&) = delete;
+
+        ~ReadGuard() {
+            slot->epoch.store(0, std::memory_order_release);
+        }
+
+        template <class K>
+        Value const *find(K const &key) const noexcept {
+            Node const *node = snapshot;
+            while (node != nullptr) {
+                if (map->comp(key, node->key)) {
+                    node = node->left;
+                } else if (map->comp(node->key, key)) {
+                    node = node->right;
+                } else {
+                    return &node->value;
+                }
+            }
+            return nullptr;
+        }
+
+        // 第一个不小于 key 的元素，不存在时两个指针均为空
+        template <class K>
+        std::pair<Key const *, Value const *>
+        lower_bound(K const &key) const noexcept {
+            Node const *node = snapshot;
+            Node const *result = nullptr;
+            while (node != nullptr) {
+                if (map->comp(node->key, key)) {
+                    node = node->right;
+                } else {
+                    result = node;
+                    node = node->left;
+                }
+            }
+            if (result == nullptr) {
+                return {nullptr, nullptr};
+            }
+            return {&result->key, &result->value};
+        }
+
+        // 按键的顺序访问快照中的每个 (key, value)
+        // AVL 树高不超过 1.44 log2(n)，固定大小的栈足够
+        template <class Visitor>
+        void for_each(Visitor &&visitor) const {
+            Node const *stack[96];
+            std::size_t depth = 0;
+            Node const *node = snapshot;
+            while (node != nullptr || depth != 0) {
+                while (node != nullptr) {
+                    stack[depth++] = node;
+                    node = node->left;
+                }
+                node = stack[--depth];
+                visitor(node->key, node->value);
+                node = node->right;
+            }
+        }
+
+        friend struct RcuMap;
+
+    private:
+        ReadGuard(RcuMap const *map) noexcept : map(map) {
+            std::size_t index = slotHint();
+            while (true) {
+                std::uint64_t epoch =
+                    map->globalEpoch.load(std::memory_order_seq_cst);
+                std::uint64_t expected = 0;
+                if (map->slots[index].epoch.compare_exchange_strong(
+                        expected, epoch, std::memory_order_seq_cst)) {
+                    break;
+                }
+                index = (index + 1) % kMaxReaders;
+                if (index == slotHint()) {
+                    std::this_thread::yield();
+                }
+            }
+            slot = &map->slots[index];
+            snapshot = map->root.load(std::memory_order_seq_cst);
+        }
+
+        RcuMap const *map;
+        ReaderSlot *slot;
+        Node const *snapshot;
+    };
+
+    RcuMap() = default;
+
+    explicit RcuMap(Compare comp) : comp(comp) {}
+
+    RcuMap(RcuMap &&) = delete;
+
+    // 析构时不得再有读者
+    ~RcuMap() {
+        destroyTree(root.load(std::memory_order_relaxed));
+        for (auto const &entry: retired) {
+            delete entry.second;
+        }
+    }
+
+    ReadGuard read() const noexcept {
+        return ReadGuard(this);
+    }
+
+    // 查找并复制出值，无锁
+    template <class K>
+    std::optional<Value> get(K const &key) const {
+        ReadGuard guard = read();
+        if (Value const *value = guard.find(key)) {
+            return *value;
+        }
+        return std::nullopt;
+    }
+
+    std::size_t size() const noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    // 插入或覆盖，返回是否为新插入
+    bool insert_or_assign(Key const &key, Value const &value) {
+        std::lock_guard lock(writeMutex);
+        bool inserted = false;
+        publish(doInsert(root.load(std::memory_order_relaxed), key, value,
+                         inserted));
+        if (inserted) {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        return inserted;
+    }
+
+    template <class K>
+    bool erase(K const &key) {
+        std::lock_guard lock(writeMutex);
+        bool erased = false;
+        Node const *newRoot =
+            doErase(root.load(std::memory_order_relaxed), key, erased);
+        if (erased) {
+            publish(newRoot);
+            count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return erased;
+    }
+};
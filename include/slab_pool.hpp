@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// 定长对象池：对象放在成块连续分配的槽位中，释放的槽位串成空闲链表复用
+// create、destroy 均为 O(1)，只有整块用完时才向系统申请新块（块大小逐次翻倍）
+// 池析构时只归还内存，不析构仍存活的对象，须由使用者先 destroy
+template <class T, std::size_t FirstChunk = 32, std::size_t MaxChunk = 4096>
+struct SlabPool {
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    Slot *freeList;
+    // 最新一块中尚未用过的槽位 [cursor, limit)
+    Slot *cursor;
+    Slot *limit;
+    std::size_t nextChunk;
+
+    Slot *allocate() {
+        if (freeList != nullptr) {
+            Slot *slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        if (cursor == limit) {
+            chunks.reserve(chunks.size() + 1);
+            chunks.emplace_back(new Slot[nextChunk]);
+            cursor = chunks.back().get();
+            limit = cursor + nextChunk;
+            nextChunk = std::min(nextChunk * 2, MaxChunk);
+        }
+        return cursor++;
+    }
+
+    void deallocate(Slot *slot) noexcept {
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+public:
+    SlabPool() noexcept
+        : freeList(nullptr),
+          cursor(nullptr),
+          limit(nullptr),
+          nextChunk(FirstChunk) {}
+
+    SlabPool(SlabPool &&) = delete;
+
+    ~SlabPool() noexcept {}
+
+    // 构造函数抛出异常时槽位归还池中
+    template <class... Args>
+    T *create(Args &&...args) {
+        Slot *slot = allocate();
+        try {
+            return ::new (static_cast<void *>(slot->storage))
+                T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(slot);
+            throw;
+        }
+    }
+
+    void destroy(T *object) noexcept {
+        object->~T();
+        deallocate(reinterpret_cast<Slot *>(object));
+    }
+
+    // 归还全部块，所有对象须已 destroy
+    void release() noexcept {
+        chunks.clear();
+        freeList = nullptr;
+        cursor = nullptr;
+        limit = nullptr;
+        nextChunk = FirstChunk;
+    }
+};
@@ -4,6 +4,7 @@
 #include <queue>
 #include <span>
 #include <thread>
+#include <variant>
 #include "debug.hpp"
 
 using namespace std::chrono_literals;
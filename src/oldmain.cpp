@@ -4,6 +4,7 @@
 #include <queue>
 #include <span>
 #include <thread>
+#include <variant>
 #include <rbtree.hpp>
 #include <debug.hpp>
 
@@ -0,0 +1,87 @@
+// 无论构建类型如何都保留全部级别
+#define DEBUG_MIN_LEVEL 0
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <debug.hpp>
+
+// 指针参数的输出须与改用 to_chars 之前相同，即与 std::ostream 的 operator<< 一致：
+// 对象指针输出地址，指向 signed char / unsigned char 的指针（不论是否 const）按字符串输出，
+// wchar_t、char16_t 等的 operator<< 被删除，仍按解引用后的首个元素输出
+
+static int failures = 0;
+
+// 捕获一条同步 debug 记录，去掉 "文件:行:\t " 前缀
+template <class T>
+std::string logged(T const &t) {
+    std::ostringstream capture;
+    auto *saved = std::cerr.rdbuf(capture.rdbuf());
+    debug(), t;
+    std::cerr.rdbuf(saved);
+    std::string line = capture.str();
+    auto pos = line.find("\t ");
+    if (pos == std::string::npos || line.empty() || line.back() != '\n') {
+        return "<malformed: " + line + ">";
+    }
+    return line.substr(pos + 2, line.size() - pos - 3);
+}
+
+template <class T>
+std::string streamed(T const &t) {
+    std::ostringstream oss;
+    oss << t;
+    return oss.str();
+}
+
+static void expect(char const *name, std::string const &got,
+                   std::string const &want) {
+    if (got != want) {
+        std::printf("FAILED %s: got \"%s\", want \"%s\"\n", name, got.c_str(),
+                    want.c_str());
+        ++failures;
+    }
+}
+
+template <class T>
+void expect_streamed(char const *name, T t) {
+    expect(name, logged(t), streamed(t));
+}
+
+int main() {
+    unsigned char us[] = "uvw";
+    signed char ss[] = "xyz";
+    wchar_t ws[] = L"wide";
+    char16_t u16[] = u"u16";
+    char32_t u32[] = U"u32";
+    int i = 7;
+    double d = 0.5;
+    bool b = true;
+
+    expect_streamed("unsigned char *", static_cast<unsigned char *>(us));
+    expect_streamed("unsigned char const *",
+                    static_cast<unsigned char const *>(us));
+    expect_streamed("signed char *", static_cast<signed char *>(ss));
+    expect_streamed("signed char const *", static_cast<signed char const *>(ss));
+    expect_streamed("int *", &i);
+    expect_streamed("double const *", static_cast<double const *>(&d));
+    expect_streamed("bool *", &b);
+    expect_streamed("void *", static_cast<void *>(&i));
+    expect_streamed("void const *", static_cast<void const *>(&i));
+    expect_streamed("null int *", static_cast<int *>(nullptr));
+
+    expect("wchar_t const *", logged(static_cast<wchar_t const *>(ws)),
+           logged(ws[0]));
+    expect("wchar_t *", logged(static_cast<wchar_t *>(ws)), logged(ws[0]));
+    expect("char16_t const *", logged(static_cast<char16_t const *>(u16)),
+           logged(u16[0]));
+    expect("char32_t const *", logged(static_cast<char32_t const *>(u32)),
+           logged(u32[0]));
+
+    if (failures != 0) {
+        return 1;
+    }
+    std::printf("ok: pointer arguments format as before\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+// 无论构建类型如何都保留全部级别
+#define DEBUG_MIN_LEVEL 0
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <debug.hpp>
+
+// rate_limit 的丢弃注明：新窗口第一条记录注明的条数只含实际被丢弃的调用，
+// 输出的行数加上注明的丢弃数须恰好等于调用次数
+
+// 多个线程共用的 cerr 缓冲区，每条记录由一次 sputn 写入
+struct capture_buffer : std::streambuf {
+    std::mutex mutex;
+    std::string text;
+
+    int overflow(int c) override {
+        std::lock_guard lock(mutex);
+        text += static_cast<char>(c);
+        return c;
+    }
+
+    std::streamsize xsputn(char const *s, std::streamsize n) override {
+        std::lock_guard lock(mutex);
+        text.append(s, static_cast<std::size_t>(n));
+        return n;
+    }
+};
+
+struct tally {
+    std::size_t lines = 0;
+    std::size_t suppressed = 0;
+    std::size_t notes = 0;
+};
+
+static tally count(std::string const &text) {
+    static constexpr std::string_view prefix = "[debug: ";
+    tally t;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string::npos) {
+            break;
+        }
+        std::size_t note = text.find(prefix, pos);
+        if (note != std::string::npos && note < end) {
+            t.suppressed += std::strtoull(text.c_str() + note + prefix.size(),
+                                          nullptr, 10);
+            ++t.notes;
+        }
+        ++t.lines;
+        pos = end + 1;
+    }
+    return t;
+}
+
+static std::uint64_t seconds() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// 等到下一秒开始，使随后的调用落在同一个新窗口中
+// rate_limit 可能读粗粒度时钟，它比 steady_clock 滞后不超过一个时钟滴答，再多等 20ms
+static void next_second() {
+    auto s = seconds();
+    while (seconds() == s) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+static void single(int i) {
+    debug().rate_limit(2), "single", i;
+}
+
+static void shared(int i) {
+    debug().rate_limit(50), "shared", i;
+}
+
+static bool fail(char const *what, tally const &t, std::size_t calls) {
+    std::printf("FAILED %s: %zu calls, %zu lines, %zu suppressed in %zu "
+                "notes\n",
+                what, calls, t.lines, t.suppressed, t.notes);
+    return false;
+}
+
+// 一个窗口内 5 次调用输出 2 条，下个窗口的第一条注明 3 条
+static bool summary(capture_buffer &buffer) {
+    next_second();
+    for (int i = 0; i < 5; ++i) {
+        single(i);
+    }
+    next_second();
+    single(5);
+    tally t = count(buffer.text);
+    if (t.lines != 3 || t.notes != 1 || t.suppressed != 3) {
+        return fail("summary", t, 6);
+    }
+    return true;
+}
+
+// 多个线程跨越若干窗口边界调用同一调用点
+static bool concurrent(capture_buffer &buffer, std::size_t threads,
+                       std::chrono::milliseconds duration) {
+    std::vector<std::size_t> calls(threads);
+    std::vector<std::thread> workers;
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    for (std::size_t k = 0; k < threads; ++k) {
+        workers.emplace_back([&, k] {
+            while (std::chrono::steady_clock::now() < deadline) {
+                shared(static_cast<int>(calls[k]++));
+            }
+        });
+    }
+    for (auto &w: workers) {
+        w.join();
+    }
+    // 再开一个窗口，注明最后一个窗口的丢弃数
+    next_second();
+    shared(-1);
+    std::size_t total = 1;
+    for (std::size_t c: calls) {
+        total += c;
+    }
+    tally t = count(buffer.text);
+    if (t.lines + t.suppressed != total) {
+        return fail("concurrent", t, total);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::size_t threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4;
+    std::chrono::milliseconds duration(
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2500);
+
+    capture_buffer summary_buffer;
+    auto *saved = std::cerr.rdbuf(&summary_buffer);
+    bool ok = summary(summary_buffer);
+    capture_buffer concurrent_buffer;
+    std::cerr.rdbuf(&concurrent_buffer);
+    ok = concurrent(concurrent_buffer, threads, duration) && ok;
+    std::cerr.rdbuf(saved);
+    if (!ok) {
+        return 1;
+    }
+    std::printf("ok: printed lines plus reported suppressions match calls\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <co_latency.hpp>
+
+// LatencyHistogram::percentile 按最近秩取值：第 ceil(q * n) 小的记录所在格的上界
+// 小值各占一格，结果精确；大值的结果不小于真实分位数，相对误差不超过 1/32
+
+static int failures = 0;
+
+static void expect(char const *name, std::uint64_t got, std::uint64_t want) {
+    if (got != want) {
+        std::printf("FAILED %s: got %llu, want %llu\n", name,
+                    static_cast<unsigned long long>(got),
+                    static_cast<unsigned long long>(want));
+        ++failures;
+    }
+}
+
+static LatencyHistogram histogramOf(std::vector<std::uint64_t> const &values) {
+    LatencyHistogram histogram;
+    for (std::uint64_t v: values) {
+        histogram.record(v);
+    }
+    return histogram;
+}
+
+static void exact() {
+    auto three = histogramOf({10, 20, 30});
+    expect("p50 of {10,20,30}", three.percentile(0.5), 20);
+    expect("p0 of {10,20,30}", three.percentile(0.0), 10);
+    expect("p100 of {10,20,30}", three.percentile(1.0), 30);
+
+    std::vector<std::uint64_t> ten;
+    for (std::uint64_t i = 1; i <= 10; ++i) {
+        ten.push_back(i);
+    }
+    auto h = histogramOf(ten);
+    expect("p50 of 1..10", h.percentile(0.5), 5);
+    expect("p99 of 1..10", h.percentile(0.99), 10);
+    expect("p10 of 1..10", h.percentile(0.1), 1);
+
+    // 0.07 * 100 在 double 中略大于 7
+    std::vector<std::uint64_t> hundred;
+    for (std::uint64_t i = 1; i <= 100; ++i) {
+        hundred.push_back(i);
+    }
+    expect("p7 of 1..100", histogramOf(hundred).percentile(0.07), 7);
+
+    expect("empty", LatencyHistogram().percentile(0.5), 0);
+}
+
+// 跨越多个数量级的随机值，与排序后的最近秩比较
+static void bounded() {
+    std::mt19937_64 rng(3);
+    std::vector<std::uint64_t> values(10007);
+    for (auto &v: values) {
+        v = rng() >> (rng() % 64);
+    }
+    auto h = histogramOf(values);
+    std::sort(values.begin(), values.end());
+    for (double q: {0.001, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+        auto rank = static_cast<std::size_t>(
+            std::ceil(q * static_cast<double>(values.size()) - 1e-9));
+        std::uint64_t want = values[std::max<std::size_t>(rank, 1) - 1];
+        std::uint64_t got = h.percentile(q);
+        if (got < want || got - want > want / 32) {
+            std::printf("FAILED q=%g: got %llu, true %llu\n", q,
+                        static_cast<unsigned long long>(got),
+                        static_cast<unsigned long long>(want));
+            ++failures;
+        }
+    }
+}
+
+int main() {
+    exact();
+    bounded();
+    if (failures != 0) {
+        return 1;
+    }
+    std::printf("ok: percentiles use the nearest rank\n");
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include <rbtree.hpp>
+
+// 参照实现：按 (键, 插入序号) 排序，即稳定多重集的预期中序
+using Reference = std::multiset<std::pair<int, std::uint64_t>>;
+
+// 维护子树大小，覆盖 validate() 的全部检查；AutoUnlink 的两种取值各跑一遍
+template <bool AutoUnlink>
+struct Fuzz {
+    struct Item;
+
+    using Tree = RbTree<Item, std::less<>, AutoUnlink, RbSizeAugment>;
+
+    struct Item : Tree::RbNode {
+        int mKey;
+        // 插入序号，等键元素应按序号排列
+        std::uint64_t mSeq;
+
+        friend bool operator<(Item const &lhs, Item const &rhs) noexcept {
+            return lhs.mKey < rhs.mKey;
+        }
+
+        friend bool operator<(Item const &lhs, int rhs) noexcept {
+            return lhs.mKey < rhs;
+        }
+
+        friend bool operator<(int lhs, Item const &rhs) noexcept {
+            return lhs < rhs.mKey;
+        }
+    };
+
+    static bool fail(char const *what, std::uint64_t op) {
+        std::printf("FAILED (AutoUnlink=%d) at op %llu: %s\n", int(AutoUnlink),
+                    static_cast<unsigned long long>(op), what);
+        return false;
+    }
+
+    // 键 key 的所有元素须恰好是参照中的那些，且按插入序号递增（FIFO）
+    static bool checkKey(Tree const &tree, Reference const &ref, int key,
+                         std::uint64_t op) {
+        auto [first, last] = tree.equal_range(key);
+        auto it = ref.lower_bound({key, 0});
+        for (; first != last; ++first, ++it) {
+            if (it == ref.end() || it->first != key ||
+                first->mSeq != it->second) {
+                return fail("equal keys out of insertion order", op);
+            }
+        }
+        if (it != ref.end() && it->first == key) {
+            return fail("equal_range misses elements", op);
+        }
+        return true;
+    }
+
+    static bool check(Tree &tree, Reference const &ref, std::uint64_t op,
+                      double &worstRatio) {
+        auto result = tree.validate();
+        if (!result) {
+            return fail(result.error, op);
+        }
+        if (result.size != ref.size() || tree.size() != ref.size()) {
+            return fail("size differs from reference", op);
+        }
+        auto it = ref.begin();
+        for (Item &item: tree) {
+            if (item.mKey != it->first || item.mSeq != it->second) {
+                return fail("inorder differs from reference", op);
+            }
+            ++it;
+        }
+        double bound = 2 * std::log2(double(result.size) + 1);
+        if (result.size != 0) {
+            double ratio = double(result.height) / bound;
+            if (ratio > worstRatio) {
+                worstRatio = ratio;
+            }
+        }
+        if (double(result.height) > bound) {
+            return fail("height exceeds 2 log2(n + 1)", op);
+        }
+        return true;
+    }
+
+    // 随机交替插入、删除（任意元素、最小元素、按键）、split/join、assign_sorted，
+    // 每步检查本步所涉键的等键顺序，每隔一段与 std::multiset 对照整棵树
+    // 并检查红黑树约束，报告树高与理论上界
+    static bool run(std::uint64_t ops, std::size_t capacity,
+                    std::uint64_t seed) {
+        // 键的范围小于容量，保证有大量等键元素
+        int keyRange = static_cast<int>(capacity / 4) + 1;
+        std::uint64_t checkEvery = capacity / 8 + 1;
+
+        std::mt19937_64 rng(seed);
+        // 树的析构不摘除结点，须先于结点构造，使任何返回路径上结点都先析构、自行摘除
+        Tree tree;
+        Tree lower;
+        Tree upper;
+        Reference ref;
+        std::vector<Item> items(capacity);
+        std::uint64_t seq = 0;
+        double worstRatio = 0;
+
+        auto erase = [&](Item &item) {
+            ref.erase(ref.find({item.mKey, item.mSeq}));
+            tree.erase(item);
+        };
+
+        std::printf("AutoUnlink=%d\n", int(AutoUnlink));
+        for (std::uint64_t op = 0; op < ops; ++op) {
+            auto r = rng();
+            Item &item = items[(r >> 16) % capacity];
+            int key = static_cast<int>((r >> 40) % keyRange);
+            switch (r % 16) {
+            case 0:
+                if (!tree.empty()) {
+                    Item &first = tree.front();
+                    auto it = ref.begin();
+                    if (first.mKey != it->first || first.mSeq != it->second) {
+                        return fail("pop_front order", op);
+                    }
+                    ref.erase(it);
+                    tree.pop_front();
+                }
+                break;
+            case 1: {
+                // 删除等键元素中最早插入的一个
+                auto found = tree.find(key);
+                auto expected = ref.lower_bound({key, 0});
+                bool hit = expected != ref.end() && expected->first == key;
+                if ((found != tree.end()) != hit ||
+                    (hit && found->mSeq != expected->second)) {
+                    return fail("find differs from reference", op);
+                }
+                if (hit) {
+                    erase(*found);
+                }
+                break;
+            }
+            case 2:
+                // 原地拆分再拼回
+                tree.split(key, lower, tree);
+                if (!lower.validate() || !tree.validate()) {
+                    return fail("split broke an invariant", op);
+                }
+                tree.join(lower, tree);
+                break;
+            case 3:
+                // 拆到另外两棵树，再拼进第三棵（即原树）
+                tree.split(key, lower, upper);
+                if (!tree.empty()) {
+                    return fail("split did not empty the source tree", op);
+                }
+                if (!lower.validate() || !upper.validate()) {
+                    return fail("split broke an invariant", op);
+                }
+                tree.join(lower, upper);
+                break;
+            case 4:
+                if (r % 4096 == 4) {
+                    std::vector<std::reference_wrapper<Item>> sorted;
+                    for (Item &i: tree) {
+                        sorted.push_back(i);
+                    }
+                    tree.assign_sorted(sorted);
+                }
+                break;
+            default:
+                if (item.is_linked()) {
+                    key = item.mKey;
+                    erase(item);
+                } else {
+                    item.mKey = key;
+                    item.mSeq = seq++;
+                    ref.insert({item.mKey, item.mSeq});
+                    tree.insert(item);
+                }
+                break;
+            }
+
+            if (!checkKey(tree, ref, key, op)) {
+                return false;
+            }
+            if (op % checkEvery == 0 && !check(tree, ref, op, worstRatio)) {
+                return false;
+            }
+            if (op % (ops / 10 + 1) == 0) {
+                auto result = tree.validate();
+                std::printf("op %10llu  size %8zu  height %3zu  black %3zu  "
+                            "bound %6.2f\n",
+                            static_cast<unsigned long long>(op), result.size,
+                            result.height, result.blackHeight,
+                            2 * std::log2(double(result.size) + 1));
+            }
+        }
+
+        if (!check(tree, ref, ops, worstRatio)) {
+            return false;
+        }
+        std::printf("ok: %llu ops, worst height / (2 log2(n + 1)) = %.3f\n",
+                    static_cast<unsigned long long>(ops), worstRatio);
+        return true;
+    }
+};
+
+int main(int argc, char **argv) {
+    std::uint64_t ops =
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t capacity =
+        argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+    std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+
+    if (!Fuzz<true>::run(ops, capacity, seed) ||
+        !Fuzz<false>::run(ops, capacity, seed + 1)) {
+        return 1;
+    }
+    return 0;
+}